@@ -0,0 +1,139 @@
+#include "autosave.h"
+#include "simulation.h"
+#include "snapshot.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+//global vars:
+static std::thread saveThread; //the thread encoding and writing captured frames
+static std::mutex saveMutex; //guards the variables below
+static std::condition_variable saveSignal; //wakes the save thread when there is a capture or it should stop
+static bool captureReady; //whether or not the capture buffer holds a frame waiting to be written
+static bool saveRunning; //whether or not the save thread should keep running
+static double captureTime; //how long the waiting capture took on the simulation thread, in milliseconds
+
+static std::vector<Particle> capture; //the single capture buffer, keeping memory use bounded to one grid
+static std::string savePath;
+static std::chrono::steady_clock::duration saveInterval;
+static std::chrono::steady_clock::time_point nextSave;
+
+//---------------------------------------------------------------//
+
+void save_thread_loop(); //the main loop of the save thread
+bool replace_file(const char* from, const char* to); //moves a file over another, replacing it in one step so a crash can't leave a half written save
+
+bool start_autosave(const char* path, double interval)
+{
+	if (interval <= 0.0)
+		return false;
+
+	savePath = path;
+	saveInterval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(interval));
+	nextSave = std::chrono::steady_clock::now() + saveInterval;
+	capture.resize(WIDTH * HEIGHT);
+
+	captureReady = false;
+	saveRunning = true;
+	saveThread = std::thread(save_thread_loop);
+
+	return saveThread.joinable();
+}
+
+void stop_autosave()
+{
+	if (!saveThread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(saveMutex);
+		saveRunning = false;
+	}
+	saveSignal.notify_one();
+	saveThread.join();
+}
+
+void update_autosave(const Particle* cells)
+{
+	if (!saveThread.joinable())
+		return;
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (now < nextSave)
+		return;
+
+	//skip this save if the last one is still being written, the capture buffer is still in use:
+	std::unique_lock<std::mutex> lock(saveMutex, std::try_to_lock);
+	if (!lock.owns_lock() || captureReady)
+		return;
+
+	//capture with a single copy, leaving the encoding and writing to the save thread:
+	memcpy(capture.data(), cells, capture.size() * sizeof(Particle));
+	captureTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - now).count();
+	captureReady = true;
+	nextSave = now + saveInterval;
+
+	lock.unlock();
+	saveSignal.notify_one();
+}
+
+//---------------------------------------------------------------//
+
+void save_thread_loop()
+{
+	std::vector<Uint8> data;
+	std::string tempPath = savePath + ".tmp";
+
+	while (true)
+	{
+		//wait for a capture:
+		std::unique_lock<std::mutex> lock(saveMutex);
+		saveSignal.wait(lock, [] { return captureReady || !saveRunning; });
+		if (!captureReady)
+			break;
+
+		double capturedIn = captureTime;
+		lock.unlock();
+
+		//encode and write the capture, the buffer is left alone by the simulation thread until captureReady is cleared:
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		data.clear();
+		encode_snapshot(capture.data(), WIDTH, HEIGHT, &data);
+
+		lock.lock();
+		captureReady = false;
+		lock.unlock();
+
+		SDL_RWops* file = SDL_RWFromFile(tempPath.c_str(), "wb");
+		bool success = file && SDL_RWwrite(file, data.data(), 1, data.size()) == data.size();
+		success = file && SDL_RWclose(file) == 0 && success;
+		success = success && replace_file(tempPath.c_str(), savePath.c_str());
+
+		double writeTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (success)
+			std::cout << "autosaved world to " << savePath << " (" << data.size() << " bytes, captured in " << capturedIn << " ms, written in " << writeTime << " ms)" << std::endl;
+		else
+			std::cout << "failed to autosave world to " << savePath << std::endl;
+	}
+}
+
+bool replace_file(const char* from, const char* to)
+{
+#ifdef _WIN32
+	return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	return rename(from, to) == 0;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+#include "particles.h"
+
+//autosave constants:
+#define DEFAULT_AUTOSAVE_PATH "autosave.esim" //the default file autosaves are written to
+
+//---------------------------------------------------------------//
+
+bool start_autosave(const char* path, double interval); //starts saving the world to the given file every interval seconds, on a background thread; returns true on success, false on failure
+void stop_autosave(); //finishes any save in progress and stops the background thread
+void update_autosave(const Particle* cells); //captures the cells for the background thread if a save is due and the last one has finished; only call from the simulation thread, between ticks
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+#include "SDL.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+//helpers for working with 64 bit words of bits, such as the occupancy bitplanes
+
+inline int count_bits(Uint64 word) //returns the number of set bits
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	return (int)__popcnt64(word);
+#elif defined(_MSC_VER)
+	//32 bit builds only have the 32 bit intrinsic, so count each half:
+	return (int)(__popcnt((unsigned int)word) + __popcnt((unsigned int)(word >> 32)));
+#else
+	return __builtin_popcountll(word);
+#endif
+}
+
+inline int lowest_bit(Uint64 word) //returns the index of the lowest set bit; word must not be 0
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return (int)index;
+#elif defined(_MSC_VER)
+	//32 bit builds only have the 32 bit intrinsic, so scan the low half, then the high one:
+	unsigned long index;
+	if (_BitScanForward(&index, (unsigned long)word))
+		return (int)index;
+	_BitScanForward(&index, (unsigned long)(word >> 32));
+	return (int)index + 32;
+#else
+	return __builtin_ctzll(word);
+#endif
+}
+
+inline int highest_bit(Uint64 word) //returns the index of the highest set bit; word must not be 0
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanReverse64(&index, word);
+	return (int)index;
+#elif defined(_MSC_VER)
+	//32 bit builds only have the 32 bit intrinsic, so scan the high half, then the low one:
+	unsigned long index;
+	if (_BitScanReverse(&index, (unsigned long)(word >> 32)))
+		return (int)index + 32;
+	_BitScanReverse(&index, (unsigned long)word);
+	return (int)index;
+#else
+	return 63 - __builtin_clzll(word);
+#endif
+}
+
+inline Uint64 bit_range(int start, int end) //returns a word with bits start through end - 1 set, for 0 <= start <= end <= 64
+{
+	Uint64 below = end == 64 ? ~(Uint64)0 : ((Uint64)1 << end) - 1;
+	return below & ~(((Uint64)1 << start) - 1);
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "byte_io.h"
+#include <cstring>
+
+ByteReader make_byte_reader(const Uint8* data, size_t size)
+{
+	ByteReader reader;
+	reader.data = data;
+	reader.size = size;
+	reader.pos = 0;
+	reader.failed = false;
+
+	return reader;
+}
+
+void write_u8(Uint8 value, std::vector<Uint8>* data)
+{
+	data->push_back(value);
+}
+
+void write_u16(Uint16 value, std::vector<Uint8>* data)
+{
+	data->push_back(value & 0xFF);
+	data->push_back(value >> 8);
+}
+
+void write_u32(Uint32 value, std::vector<Uint8>* data)
+{
+	for (int i = 0; i < 4; i++)
+		data->push_back((value >> (i * 8)) & 0xFF);
+}
+
+void write_u64(Uint64 value, std::vector<Uint8>* data)
+{
+	for (int i = 0; i < 8; i++)
+		data->push_back((value >> (i * 8)) & 0xFF);
+}
+
+void write_f32(float value, std::vector<Uint8>* data)
+{
+	Uint32 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	write_u32(bits, data);
+}
+
+void write_varint(Uint64 value, std::vector<Uint8>* data)
+{
+	while (value >= 0x80)
+	{
+		data->push_back((Uint8)(value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+
+	data->push_back((Uint8)value);
+}
+
+void write_zigzag(Sint64 value, std::vector<Uint8>* data)
+{
+	write_varint(((Uint64)value << 1) ^ (Uint64)(value >> 63), data);
+}
+
+Uint8 read_u8(ByteReader* reader)
+{
+	if (reader->pos >= reader->size)
+	{
+		reader->failed = true;
+		return 0;
+	}
+
+	return reader->data[reader->pos++];
+}
+
+Uint16 read_u16(ByteReader* reader)
+{
+	Uint16 value = read_u8(reader);
+	value |= read_u8(reader) << 8;
+	return value;
+}
+
+Uint32 read_u32(ByteReader* reader)
+{
+	Uint32 value = 0;
+	for (int i = 0; i < 4; i++)
+		value |= (Uint32)read_u8(reader) << (i * 8);
+
+	return value;
+}
+
+Uint64 read_u64(ByteReader* reader)
+{
+	Uint64 value = 0;
+	for (int i = 0; i < 8; i++)
+		value |= (Uint64)read_u8(reader) << (i * 8);
+
+	return value;
+}
+
+float read_f32(ByteReader* reader)
+{
+	Uint32 bits = read_u32(reader);
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+Uint64 read_varint(ByteReader* reader)
+{
+	Uint64 value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		Uint8 byte = read_u8(reader);
+		value |= (Uint64)(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return value;
+	}
+
+	reader->failed = true;
+	return 0;
+}
+
+Sint64 read_zigzag(ByteReader* reader)
+{
+	Uint64 value = read_varint(reader);
+	return (Sint64)(value >> 1) ^ -(Sint64)(value & 1);
+}
+
+bool read_file(const char* path, std::vector<Uint8>* data)
+{
+	SDL_RWops* file = SDL_RWFromFile(path, "rb");
+	if (!file)
+		return false;
+
+	Sint64 size = SDL_RWsize(file);
+	data->resize(size > 0 ? (size_t)size : 0);
+	bool success = size >= 0 && SDL_RWread(file, data->data(), 1, data->size()) == data->size();
+	SDL_RWclose(file);
+
+	return success;
+}
\ No newline at end of file
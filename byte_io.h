@@ -0,0 +1,36 @@
+#pragma once
+#include "SDL.h"
+#include <cstddef>
+#include <vector>
+
+//helpers for reading and writing binary files; integers are little-endian and varints are LEB128
+
+struct ByteReader //for reading encoded data without running off the end
+{
+	const Uint8* data;
+	size_t size;
+	size_t pos;
+	bool failed; //set once any read runs off the end or is malformed, after which reads return 0
+};
+
+//---------------------------------------------------------------//
+
+ByteReader make_byte_reader(const Uint8* data, size_t size); //returns a reader positioned at the start of the data
+
+void write_u8(Uint8 value, std::vector<Uint8>* data);
+void write_u16(Uint16 value, std::vector<Uint8>* data);
+void write_u32(Uint32 value, std::vector<Uint8>* data);
+void write_u64(Uint64 value, std::vector<Uint8>* data);
+void write_f32(float value, std::vector<Uint8>* data);
+void write_varint(Uint64 value, std::vector<Uint8>* data);
+void write_zigzag(Sint64 value, std::vector<Uint8>* data); //writes a signed value as a varint, keeping small negative values small
+
+Uint8 read_u8(ByteReader* reader);
+Uint16 read_u16(ByteReader* reader);
+Uint32 read_u32(ByteReader* reader);
+Uint64 read_u64(ByteReader* reader);
+float read_f32(ByteReader* reader);
+Uint64 read_varint(ByteReader* reader);
+Sint64 read_zigzag(ByteReader* reader);
+
+bool read_file(const char* path, std::vector<Uint8>* data); //reads a whole file; returns true on success, false on failure
\ No newline at end of file
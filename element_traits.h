@@ -0,0 +1,252 @@
+#pragma once
+#include "particles.h"
+#include <utility>
+
+//traits constants:
+#define BUILTIN_ELEMENT_COUNT 13 //the number of particle types with traits, including empty; they are numbered from 0 without gaps, custom elements follow them
+
+enum class Kernel //the generic update an element is built on
+{
+	none, //never updated
+	liquid,
+	moveableSolid,
+	gas,
+	fire
+};
+
+struct DefaultTraits //the values every element starts from; elements derive from this and override what applies to them
+{
+	static constexpr const char* name = "";
+	static constexpr ParticleFlag flag = ParticleFlag::solid;
+	static constexpr Kernel kernel = Kernel::none;
+	static constexpr Uint8 classes = 0; //the ELEMENT_ class flags
+	static constexpr bool isStatic = true; //whether or not the sweep skips it without updating it
+
+	//liquids:
+	static constexpr int density = 0; //liquids sink through lighter liquids, in kg/m^3
+	static constexpr int spreadDistance = 0; //the furthest it moves sideways in one update
+
+	//moveable solids:
+	static constexpr float spread = 1.0f; //divides the sideways speed it picks up when it lands
+	static constexpr int inertialResistance = 1; //one in this many chance of knocking loose the particles it touches while moving
+	static constexpr int slipChance = 1; //one in this many chance of sliding diagonally while at rest
+
+	//aging:
+	static constexpr int baseHealth = 0; //the number of updates it lasts, 0 if it doesn't age
+	static constexpr ParticleType decaysTo = ParticleType::empty; //what it turns into when its health runs out
+
+	//reactions:
+	static constexpr bool boils = false; //turns to steam next to lava, cooling it to stone
+	static constexpr bool corrodes = false; //eats through its neighbors, turning to toxic gas
+	static constexpr bool ignites = false; //sets flammable neighbors alight
+	static constexpr int corrosion = 0; //one in this many chance of being eaten by acid each update, 0 if acid can't eat it
+	static constexpr int flammability = 0; //one in this many chance of catching fire each update, 0 if it can't; -1 if it puts fire out, -2 if it also turns to steam doing so
+	static constexpr int fireHealth = 0; //how long it burns for once alight
+};
+
+template<ParticleType type>
+struct ElementTraits; //the compile-time constants of every element, the kernels are instantiated with these
+
+//---------------------------------------------------------------//
+
+template<>
+struct ElementTraits<ParticleType::oil> : DefaultTraits
+{
+	static constexpr const char* name = "oil";
+	static constexpr ParticleFlag flag = ParticleFlag::liquid;
+	static constexpr Kernel kernel = Kernel::liquid;
+	static constexpr Uint8 classes = ELEMENT_LIQUID;
+	static constexpr bool isStatic = false;
+	static constexpr int density = 800;
+	static constexpr int spreadDistance = 4;
+	static constexpr int flammability = 10;
+	static constexpr int fireHealth = 50;
+};
+
+template<>
+struct ElementTraits<ParticleType::water> : DefaultTraits
+{
+	static constexpr const char* name = "water";
+	static constexpr ParticleFlag flag = ParticleFlag::liquid;
+	static constexpr Kernel kernel = Kernel::liquid;
+	static constexpr Uint8 classes = ELEMENT_LIQUID;
+	static constexpr bool isStatic = false;
+	static constexpr int density = 1000;
+	static constexpr int spreadDistance = 4;
+	static constexpr bool boils = true;
+	static constexpr int flammability = -2;
+};
+
+template<>
+struct ElementTraits<ParticleType::acid> : DefaultTraits
+{
+	static constexpr const char* name = "acid";
+	static constexpr ParticleFlag flag = ParticleFlag::liquid;
+	static constexpr Kernel kernel = Kernel::liquid;
+	static constexpr Uint8 classes = ELEMENT_LIQUID | ELEMENT_REACTIVE;
+	static constexpr bool isStatic = false;
+	static constexpr int density = 1200;
+	static constexpr int spreadDistance = 2;
+	static constexpr bool corrodes = true;
+	static constexpr int flammability = -1;
+};
+
+template<>
+struct ElementTraits<ParticleType::lava> : DefaultTraits
+{
+	static constexpr const char* name = "lava";
+	static constexpr ParticleFlag flag = ParticleFlag::liquid;
+	static constexpr Kernel kernel = Kernel::liquid;
+	static constexpr Uint8 classes = ELEMENT_LIQUID | ELEMENT_REACTIVE;
+	static constexpr bool isStatic = false;
+	static constexpr int density = 3100;
+	static constexpr int spreadDistance = 1;
+	static constexpr bool ignites = true;
+};
+
+template<>
+struct ElementTraits<ParticleType::sand> : DefaultTraits
+{
+	static constexpr const char* name = "sand";
+	static constexpr Kernel kernel = Kernel::moveableSolid;
+	static constexpr Uint8 classes = ELEMENT_GRANULAR;
+	static constexpr bool isStatic = false;
+	static constexpr float spread = 1.5f;
+	static constexpr int inertialResistance = 2;
+	static constexpr int slipChance = 1000;
+	static constexpr int corrosion = 50;
+};
+
+template<>
+struct ElementTraits<ParticleType::gunpowder> : DefaultTraits
+{
+	static constexpr const char* name = "gunpowder";
+	static constexpr Kernel kernel = Kernel::moveableSolid;
+	static constexpr Uint8 classes = ELEMENT_GRANULAR;
+	static constexpr bool isStatic = false;
+	static constexpr float spread = 2.0f;
+	static constexpr int inertialResistance = 4;
+	static constexpr int slipChance = 3000;
+	static constexpr int corrosion = 50;
+	static constexpr int flammability = 12;
+	static constexpr int fireHealth = 20;
+};
+
+template<>
+struct ElementTraits<ParticleType::wood> : DefaultTraits
+{
+	static constexpr const char* name = "wood";
+	static constexpr int corrosion = 30;
+	static constexpr int flammability = 60;
+	static constexpr int fireHealth = 200;
+};
+
+template<>
+struct ElementTraits<ParticleType::stone> : DefaultTraits
+{
+	static constexpr const char* name = "stone";
+	static constexpr int corrosion = 60;
+};
+
+template<>
+struct ElementTraits<ParticleType::toxicGas> : DefaultTraits
+{
+	static constexpr const char* name = "toxic_gas";
+	static constexpr ParticleFlag flag = ParticleFlag::gas;
+	static constexpr Kernel kernel = Kernel::gas;
+	static constexpr Uint8 classes = ELEMENT_GAS;
+	static constexpr bool isStatic = false;
+	static constexpr int flammability = 12;
+	static constexpr int fireHealth = 50;
+};
+
+template<>
+struct ElementTraits<ParticleType::steam> : DefaultTraits
+{
+	static constexpr const char* name = "steam";
+	static constexpr ParticleFlag flag = ParticleFlag::gas;
+	static constexpr Kernel kernel = Kernel::gas;
+	static constexpr Uint8 classes = ELEMENT_GAS | ELEMENT_AGING;
+	static constexpr bool isStatic = false;
+	static constexpr int baseHealth = 300;
+	static constexpr ParticleType decaysTo = ParticleType::water;
+};
+
+template<>
+struct ElementTraits<ParticleType::smoke> : DefaultTraits
+{
+	static constexpr const char* name = "smoke";
+	static constexpr ParticleFlag flag = ParticleFlag::gas;
+	static constexpr Kernel kernel = Kernel::gas;
+	static constexpr Uint8 classes = ELEMENT_GAS | ELEMENT_AGING;
+	static constexpr bool isStatic = false;
+	static constexpr int baseHealth = 400;
+};
+
+template<>
+struct ElementTraits<ParticleType::fire> : DefaultTraits
+{
+	static constexpr const char* name = "fire";
+	static constexpr Kernel kernel = Kernel::fire;
+	static constexpr Uint8 classes = ELEMENT_REACTIVE | ELEMENT_AGING;
+	static constexpr bool isStatic = false;
+	static constexpr int baseHealth = 5;
+};
+
+template<>
+struct ElementTraits<ParticleType::empty> : DefaultTraits
+{
+	static constexpr const char* name = "empty";
+	static constexpr ParticleFlag flag = ParticleFlag::empty;
+};
+
+//---------------------------------------------------------------//
+
+template<typename Sequence>
+struct ElementTables; //the traits of every built-in element gathered into arrays indexed by type, which the element table starts from
+
+template<int... types>
+struct ElementTables<std::integer_sequence<int, types...>>
+{
+	static constexpr const char* name[] = { ElementTraits<(ParticleType)types>::name... };
+	static constexpr ParticleFlag flag[] = { ElementTraits<(ParticleType)types>::flag... };
+	static constexpr Kernel kernel[] = { ElementTraits<(ParticleType)types>::kernel... };
+	static constexpr Uint8 classes[] = { ElementTraits<(ParticleType)types>::classes... };
+	static constexpr bool isStatic[] = { ElementTraits<(ParticleType)types>::isStatic... };
+	static constexpr int density[] = { ElementTraits<(ParticleType)types>::density... };
+	static constexpr int spreadDistance[] = { ElementTraits<(ParticleType)types>::spreadDistance... };
+	static constexpr float spread[] = { ElementTraits<(ParticleType)types>::spread... };
+	static constexpr int inertialResistance[] = { ElementTraits<(ParticleType)types>::inertialResistance... };
+	static constexpr int slipChance[] = { ElementTraits<(ParticleType)types>::slipChance... };
+	static constexpr int baseHealth[] = { ElementTraits<(ParticleType)types>::baseHealth... };
+	static constexpr ParticleType decaysTo[] = { ElementTraits<(ParticleType)types>::decaysTo... };
+	static constexpr bool boils[] = { ElementTraits<(ParticleType)types>::boils... };
+	static constexpr bool corrodes[] = { ElementTraits<(ParticleType)types>::corrodes... };
+	static constexpr bool ignites[] = { ElementTraits<(ParticleType)types>::ignites... };
+	static constexpr int corrosion[] = { ElementTraits<(ParticleType)types>::corrosion... };
+	static constexpr int flammability[] = { ElementTraits<(ParticleType)types>::flammability... };
+	static constexpr int fireHealth[] = { ElementTraits<(ParticleType)types>::fireHealth... };
+};
+
+//indexing the arrays at runtime needs them defined outside the class:
+template<int... types> constexpr const char* const ElementTables<std::integer_sequence<int, types...>>::name[];
+template<int... types> constexpr ParticleFlag ElementTables<std::integer_sequence<int, types...>>::flag[];
+template<int... types> constexpr Kernel ElementTables<std::integer_sequence<int, types...>>::kernel[];
+template<int... types> constexpr Uint8 ElementTables<std::integer_sequence<int, types...>>::classes[];
+template<int... types> constexpr bool ElementTables<std::integer_sequence<int, types...>>::isStatic[];
+template<int... types> constexpr int ElementTables<std::integer_sequence<int, types...>>::density[];
+template<int... types> constexpr int ElementTables<std::integer_sequence<int, types...>>::spreadDistance[];
+template<int... types> constexpr float ElementTables<std::integer_sequence<int, types...>>::spread[];
+template<int... types> constexpr int ElementTables<std::integer_sequence<int, types...>>::inertialResistance[];
+template<int... types> constexpr int ElementTables<std::integer_sequence<int, types...>>::slipChance[];
+template<int... types> constexpr int ElementTables<std::integer_sequence<int, types...>>::baseHealth[];
+template<int... types> constexpr ParticleType ElementTables<std::integer_sequence<int, types...>>::decaysTo[];
+template<int... types> constexpr bool ElementTables<std::integer_sequence<int, types...>>::boils[];
+template<int... types> constexpr bool ElementTables<std::integer_sequence<int, types...>>::corrodes[];
+template<int... types> constexpr bool ElementTables<std::integer_sequence<int, types...>>::ignites[];
+template<int... types> constexpr int ElementTables<std::integer_sequence<int, types...>>::corrosion[];
+template<int... types> constexpr int ElementTables<std::integer_sequence<int, types...>>::flammability[];
+template<int... types> constexpr int ElementTables<std::integer_sequence<int, types...>>::fireHealth[];
+
+typedef std::make_integer_sequence<int, BUILTIN_ELEMENT_COUNT> ElementSequence; //every built-in particle type
+typedef ElementTables<ElementSequence> BuiltinElements; //the traits tables of every built-in particle type
\ No newline at end of file
@@ -0,0 +1,465 @@
+#include "elements.h"
+#include "reactions.h"
+#include "simulation.h"
+#include "byte_io.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct ConfigReaction //a reaction from a config file, kept until the reaction table is built
+{
+	int type;
+	int other;
+	ReactionRule rule;
+};
+
+//global vars:
+ElementTable elements;
+
+static std::vector<ConfigReaction> configReactions; //the reactions the config file set, replacing those derived from the elements' properties
+
+//---------------------------------------------------------------//
+
+void reset_elements(); //fills the table with just the built-in elements, from their traits
+bool load_elements(const char* path); //applies a config file to the table; returns true on success, false on failure after saying where
+bool set_property(int type, const std::string& key, const std::string& value, std::string* decaysTo); //sets one property of an element from a config line; returns true on success, false if the key or value is invalid
+bool parse_reaction(int type, const std::string& value, ConfigReaction* reaction); //reads a "react" value, looking up the elements it names; returns true on success, false if it is invalid
+bool parse_product(const std::string& name, int* product); //sets the reaction product with the given name, an element, "same" or "burning"; returns true on success, false if there isn't one
+void set_defaults(int type); //gives a new element the default traits, a static solid that doesn't react
+void copy_element(int from, int to); //copies every property of an element but its name
+void derive_classes(int type); //works out the class flags of a loaded element from its properties, all but ELEMENT_REACTIVE which the reaction table sets
+bool parse_int(const std::string& value, int min, int max, int* result); //returns true if the value is a whole number in range, false otherwise
+std::string trim(const std::string& text); //returns the text without leading and trailing whitespace
+
+bool init_elements(const char* path)
+{
+	reset_elements();
+	configReactions.clear();
+	if (path && !load_elements(path))
+		return false;
+
+	build_reactions();
+	for (size_t i = 0; i < configReactions.size(); i++)
+		set_reaction(configReactions[i].type, configReactions[i].other, configReactions[i].rule);
+
+	build_descriptors();
+	return true;
+}
+
+int find_element(const char* name)
+{
+	for (int i = 0; i < elements.count; i++)
+		if (strcmp(elements.name[i], name) == 0)
+			return i;
+
+	return -1;
+}
+
+Uint32 hash_elements()
+{
+	Uint32 hash = 2166136261u;
+	for (int i = 0; i < elements.count; i++)
+		for (const char* c = elements.name[i]; ; c++)
+		{
+			hash ^= (Uint8)*c;
+			hash *= 16777619u;
+			if (*c == '\0')
+				break;
+		}
+
+	return hash;
+}
+
+//---------------------------------------------------------------//
+
+void reset_elements()
+{
+	memset(&elements, 0, sizeof(ElementTable));
+	elements.count = BUILTIN_ELEMENT_COUNT;
+
+	for (int i = 0; i < MAX_PARTICLE_TYPES; i++)
+	{
+		elements.isStatic[i] = true;
+		elements.decaysTo[i] = ParticleType::empty;
+	}
+
+	for (int i = 0; i < BUILTIN_ELEMENT_COUNT; i++)
+	{
+		memcpy(elements.name[i], BuiltinElements::name[i], strlen(BuiltinElements::name[i]));
+		elements.color[i] = PARTICLE_COLORS[i];
+		elements.flag[i] = BuiltinElements::flag[i];
+		elements.kernel[i] = BuiltinElements::kernel[i];
+		elements.classes[i] = BuiltinElements::classes[i];
+		elements.isStatic[i] = BuiltinElements::isStatic[i];
+
+		elements.density[i] = BuiltinElements::density[i];
+		elements.spreadDistance[i] = BuiltinElements::spreadDistance[i];
+		elements.spread[i] = BuiltinElements::spread[i];
+		elements.inertialResistance[i] = BuiltinElements::inertialResistance[i];
+		elements.slipChance[i] = BuiltinElements::slipChance[i];
+		elements.baseHealth[i] = BuiltinElements::baseHealth[i];
+		elements.decaysTo[i] = BuiltinElements::decaysTo[i];
+
+		elements.boils[i] = BuiltinElements::boils[i];
+		elements.corrodes[i] = BuiltinElements::corrodes[i];
+		elements.ignites[i] = BuiltinElements::ignites[i];
+		elements.corrosion[i] = BuiltinElements::corrosion[i];
+		elements.flammability[i] = BuiltinElements::flammability[i];
+		elements.fireHealth[i] = BuiltinElements::fireHealth[i];
+	}
+}
+
+bool load_elements(const char* path)
+{
+	std::vector<Uint8> data;
+	if (!read_file(path, &data))
+		return false;
+
+	std::string text(data.begin(), data.end());
+	std::vector<std::string> decaysTo(MAX_PARTICLE_TYPES); //the names elements decay to, looked up once every element is defined
+	std::vector<int> decaysToLine(MAX_PARTICLE_TYPES);
+	std::vector<std::pair<int, std::string>> reactions; //the element and value of every "react" line, looked up once every element is defined
+	std::vector<int> reactionLines;
+
+	int type = -1; //the element of the current section
+	int lineNumber = 0;
+	size_t pos = 0;
+	while (pos < text.size())
+	{
+		size_t end = text.find('\n', pos);
+		if (end == std::string::npos)
+			end = text.size();
+
+		std::string line = text.substr(pos, end - pos);
+		pos = end + 1;
+		lineNumber++;
+
+		line = trim(line.substr(0, line.find('#')));
+		if (line.empty())
+			continue;
+
+		//start a new element, or go back to changing an existing one:
+		if (line[0] == '[')
+		{
+			std::string name = line.back() == ']' ? trim(line.substr(1, line.size() - 2)) : "";
+			if (name.empty() || name.size() >= ELEMENT_NAME_SIZE || name.find_first_of(" \t") != std::string::npos || name == "empty")
+			{
+				std::cout << path << ":" << lineNumber << ": invalid element name" << std::endl;
+				return false;
+			}
+
+			type = find_element(name.c_str());
+			if (type < 0)
+			{
+				if (elements.count >= MAX_ELEMENTS)
+				{
+					std::cout << path << ":" << lineNumber << ": too many elements, at most " << MAX_ELEMENTS << " are supported" << std::endl;
+					return false;
+				}
+
+				type = elements.count++;
+				memcpy(elements.name[type], name.c_str(), name.size());
+				set_defaults(type);
+			}
+			elements.loaded[type] = true;
+
+			continue;
+		}
+
+		size_t equals = line.find('=');
+		if (type < 0 || equals == std::string::npos)
+		{
+			std::cout << path << ":" << lineNumber << ": expected an element section or a \"key = value\" line" << std::endl;
+			return false;
+		}
+
+		std::string key = trim(line.substr(0, equals));
+		std::string value = trim(line.substr(equals + 1));
+		if (key == "react")
+		{
+			reactions.push_back(std::make_pair(type, value));
+			reactionLines.push_back(lineNumber);
+			continue;
+		}
+
+		if (!set_property(type, key, value, &decaysTo[type]))
+		{
+			std::cout << path << ":" << lineNumber << ": invalid " << key << " \"" << value << "\"" << std::endl;
+			return false;
+		}
+		if (key == "decays_to")
+			decaysToLine[type] = lineNumber;
+	}
+
+	//now every element is defined, look up what they decay to and work out their classes:
+	for (int i = 0; i < elements.count; i++)
+	{
+		if (!elements.loaded[i])
+			continue;
+
+		if (!decaysTo[i].empty())
+		{
+			int decayType = find_element(decaysTo[i].c_str());
+			if (decayType < 0)
+			{
+				std::cout << path << ":" << decaysToLine[i] << ": unknown element \"" << decaysTo[i] << "\"" << std::endl;
+				return false;
+			}
+			elements.decaysTo[i] = (ParticleType)decayType;
+		}
+
+		derive_classes(i);
+	}
+
+	for (size_t i = 0; i < reactions.size(); i++)
+	{
+		ConfigReaction reaction;
+		if (!parse_reaction(reactions[i].first, reactions[i].second, &reaction))
+		{
+			std::cout << path << ":" << reactionLines[i] << ": invalid react \"" << reactions[i].second << "\"" << std::endl;
+			return false;
+		}
+		configReactions.push_back(reaction);
+	}
+
+	return true;
+}
+
+bool set_property(int type, const std::string& key, const std::string& value, std::string* decaysTo)
+{
+	if (key == "like")
+	{
+		int from = find_element(value.c_str());
+		if (from < 0 || from == type || from == (int)ParticleType::empty)
+			return false;
+
+		copy_element(from, type);
+	}
+	else if (key == "class")
+	{
+		if (value == "liquid")
+		{
+			elements.flag[type] = ParticleFlag::liquid;
+			elements.kernel[type] = Kernel::liquid;
+		}
+		else if (value == "granular")
+		{
+			elements.flag[type] = ParticleFlag::solid;
+			elements.kernel[type] = Kernel::moveableSolid;
+		}
+		else if (value == "gas")
+		{
+			elements.flag[type] = ParticleFlag::gas;
+			elements.kernel[type] = Kernel::gas;
+		}
+		else if (value == "solid")
+		{
+			elements.flag[type] = ParticleFlag::solid;
+			elements.kernel[type] = Kernel::none;
+		}
+		else if (value == "fire")
+		{
+			elements.flag[type] = ParticleFlag::solid;
+			elements.kernel[type] = Kernel::fire;
+		}
+		else
+			return false;
+
+		elements.isStatic[type] = elements.kernel[type] == Kernel::none;
+	}
+	else if (key == "color")
+	{
+		Uint8 rgb[3];
+		const char* text = value.c_str();
+		for (int i = 0; i < 3; i++)
+		{
+			char* end;
+			long component = strtol(text, &end, 10);
+			if (end == text || component < 0 || component > 255)
+				return false;
+
+			rgb[i] = (Uint8)component;
+			text = end;
+		}
+		if (!trim(text).empty())
+			return false;
+
+		elements.color[type] = { rgb[0], rgb[1], rgb[2], 255 };
+	}
+	else if (key == "density")
+		return parse_int(value, 0, 1000000, &elements.density[type]);
+	else if (key == "spread_distance")
+		return parse_int(value, 0, WIDTH, &elements.spreadDistance[type]);
+	else if (key == "spread")
+	{
+		char* end;
+		float spread = strtof(value.c_str(), &end);
+		if (value.empty() || *end != '\0' || !(spread > 0.0f))
+			return false;
+
+		elements.spread[type] = spread;
+	}
+	else if (key == "inertial_resistance")
+		return parse_int(value, 1, 1000000, &elements.inertialResistance[type]);
+	else if (key == "slip_chance")
+		return parse_int(value, 1, 1000000, &elements.slipChance[type]);
+	else if (key == "lifetime")
+		return parse_int(value, 0, 1000000, &elements.baseHealth[type]);
+	else if (key == "corrosion")
+		return parse_int(value, 0, 1000000, &elements.corrosion[type]);
+	else if (key == "flammability")
+		return parse_int(value, -2, 1000000, &elements.flammability[type]);
+	else if (key == "burn_time")
+		return parse_int(value, 0, 1000000, &elements.fireHealth[type]);
+	else if (key == "decays_to")
+	{
+		if (value.empty())
+			return false;
+
+		*decaysTo = value;
+	}
+	else if (key == "boils" || key == "corrodes" || key == "ignites")
+	{
+		if (value != "true" && value != "false")
+			return false;
+
+		bool* flags = key == "boils" ? elements.boils : key == "corrodes" ? elements.corrodes : elements.ignites;
+		flags[type] = value == "true";
+	}
+	else
+		return false;
+
+	return true;
+}
+
+void set_defaults(int type)
+{
+	elements.color[type] = { 255, 255, 255, 255 };
+	elements.flag[type] = DefaultTraits::flag;
+	elements.kernel[type] = DefaultTraits::kernel;
+	elements.classes[type] = DefaultTraits::classes;
+	elements.isStatic[type] = DefaultTraits::isStatic;
+
+	elements.density[type] = DefaultTraits::density;
+	elements.spreadDistance[type] = DefaultTraits::spreadDistance;
+	elements.spread[type] = DefaultTraits::spread;
+	elements.inertialResistance[type] = DefaultTraits::inertialResistance;
+	elements.slipChance[type] = DefaultTraits::slipChance;
+	elements.baseHealth[type] = DefaultTraits::baseHealth;
+	elements.decaysTo[type] = DefaultTraits::decaysTo;
+
+	elements.boils[type] = DefaultTraits::boils;
+	elements.corrodes[type] = DefaultTraits::corrodes;
+	elements.ignites[type] = DefaultTraits::ignites;
+	elements.corrosion[type] = DefaultTraits::corrosion;
+	elements.flammability[type] = DefaultTraits::flammability;
+	elements.fireHealth[type] = DefaultTraits::fireHealth;
+}
+
+void copy_element(int from, int to)
+{
+	elements.color[to] = elements.color[from];
+	elements.flag[to] = elements.flag[from];
+	elements.kernel[to] = elements.kernel[from];
+	elements.classes[to] = elements.classes[from];
+	elements.isStatic[to] = elements.isStatic[from];
+
+	elements.density[to] = elements.density[from];
+	elements.spreadDistance[to] = elements.spreadDistance[from];
+	elements.spread[to] = elements.spread[from];
+	elements.inertialResistance[to] = elements.inertialResistance[from];
+	elements.slipChance[to] = elements.slipChance[from];
+	elements.baseHealth[to] = elements.baseHealth[from];
+	elements.decaysTo[to] = elements.decaysTo[from];
+
+	elements.boils[to] = elements.boils[from];
+	elements.corrodes[to] = elements.corrodes[from];
+	elements.ignites[to] = elements.ignites[from];
+	elements.corrosion[to] = elements.corrosion[from];
+	elements.flammability[to] = elements.flammability[from];
+	elements.fireHealth[to] = elements.fireHealth[from];
+}
+
+void derive_classes(int type)
+{
+	Uint8 classes = 0;
+	if (elements.kernel[type] == Kernel::liquid)
+		classes |= ELEMENT_LIQUID;
+	if (elements.kernel[type] == Kernel::moveableSolid)
+		classes |= ELEMENT_GRANULAR;
+	if (elements.kernel[type] == Kernel::gas)
+		classes |= ELEMENT_GAS;
+	if (elements.baseHealth[type] > 0)
+		classes |= ELEMENT_AGING;
+
+	elements.classes[type] = classes;
+}
+
+bool parse_reaction(int type, const std::string& value, ConfigReaction* reaction)
+{
+	//split into the other element, both products and the chance:
+	std::vector<std::string> words;
+	size_t pos = value.find_first_not_of(" \t");
+	while (pos != std::string::npos)
+	{
+		size_t end = value.find_first_of(" \t", pos);
+		words.push_back(value.substr(pos, end == std::string::npos ? std::string::npos : end - pos));
+		pos = value.find_first_not_of(" \t", end);
+	}
+	if (words.size() != 4)
+		return false;
+
+	int other = find_element(words[0].c_str());
+	int product;
+	int otherProduct;
+	int oneIn;
+	if (other < 0 || !parse_product(words[1], &product) || !parse_product(words[2], &otherProduct) || !parse_int(words[3], 1, REACTION_ROLL_RANGE, &oneIn))
+		return false;
+
+	reaction->type = type;
+	reaction->other = other;
+	reaction->rule.product = (Sint16)product;
+	reaction->rule.otherProduct = (Sint16)otherProduct;
+	reaction->rule.chance = (Uint16)(REACTION_ROLL_RANGE / oneIn);
+	reaction->rule.neighbors = NEIGHBORS_ALL;
+	reaction->rule.counted = 0;
+	reaction->rule.once = false;
+	return true;
+}
+
+bool parse_product(const std::string& name, int* product)
+{
+	if (name == "same")
+		*product = PRODUCT_UNCHANGED;
+	else if (name == "burning")
+		*product = PRODUCT_BURNING;
+	else
+	{
+		*product = find_element(name.c_str());
+		return *product >= 0;
+	}
+
+	return true;
+}
+
+bool parse_int(const std::string& value, int min, int max, int* result)
+{
+	char* end;
+	long number = strtol(value.c_str(), &end, 10);
+	if (value.empty() || *end != '\0' || number < min || number > max)
+		return false;
+
+	*result = (int)number;
+	return true;
+}
+
+std::string trim(const std::string& text)
+{
+	size_t start = text.find_first_not_of(" \t\r");
+	if (start == std::string::npos)
+		return "";
+
+	return text.substr(start, text.find_last_not_of(" \t\r") - start + 1);
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+#include "element_traits.h"
+
+//element table constants:
+#define ELEMENT_NAME_SIZE 32 //the most bytes an element's name takes, including the terminator
+#define MAX_ELEMENTS (MAX_PARTICLE_TYPES - 1) //the most elements that can be defined, leaving the last byte value free to mark cells with no type
+
+//element config files are plain text, with a section per element naming it in brackets followed by "key = value" lines, and # starting a comment:
+//  [brine]
+//  like = water (start from a copy of an element defined before this one)
+//  class = liquid (liquid, granular, gas, solid or fire)
+//  color = 40 110 160 (red, green and blue from 0 to 255)
+//  density, spread_distance, spread, inertial_resistance, slip_chance, corrosion, flammability, burn_time, lifetime = numbers, see DefaultTraits
+//  decays_to = water (any element in the file or built in)
+//  boils, corrodes, ignites = true or false
+//  react = wood same burning 40 (the other element, what this one and the other turn into, each an element, "same" or "burning", and the chance as one in this many ticks; replaces the reaction worked out from their properties)
+//a section naming a built-in element changes its properties instead of adding a new element
+
+struct ElementTable //the properties of every element, built-in and custom, compiled into dense arrays the kernels index by type
+{
+	int count; //the number of types in use, the built-in ones followed by any custom ones
+	bool loaded[MAX_PARTICLE_TYPES]; //whether or not an element's properties came from a config file, so its kernel has to read them from here instead of the traits it was compiled with
+
+	char name[MAX_PARTICLE_TYPES][ELEMENT_NAME_SIZE];
+	SDL_Color color[MAX_PARTICLE_TYPES];
+	ParticleFlag flag[MAX_PARTICLE_TYPES];
+	Kernel kernel[MAX_PARTICLE_TYPES];
+	Uint8 classes[MAX_PARTICLE_TYPES];
+	bool isStatic[MAX_PARTICLE_TYPES];
+
+	int density[MAX_PARTICLE_TYPES];
+	int spreadDistance[MAX_PARTICLE_TYPES];
+	float spread[MAX_PARTICLE_TYPES];
+	int inertialResistance[MAX_PARTICLE_TYPES];
+	int slipChance[MAX_PARTICLE_TYPES];
+	int baseHealth[MAX_PARTICLE_TYPES];
+	ParticleType decaysTo[MAX_PARTICLE_TYPES];
+
+	bool boils[MAX_PARTICLE_TYPES];
+	bool corrodes[MAX_PARTICLE_TYPES];
+	bool ignites[MAX_PARTICLE_TYPES];
+	int corrosion[MAX_PARTICLE_TYPES];
+	int flammability[MAX_PARTICLE_TYPES];
+	int fireHealth[MAX_PARTICLE_TYPES];
+};
+
+extern ElementTable elements; //the element table, filled in by init_elements()
+
+//---------------------------------------------------------------//
+
+bool init_elements(const char* path); //fills the element table with the built-in elements, then with the custom elements and changes in the config file at path if it isn't NULL, and builds the descriptors; returns true on success, false on failure
+int find_element(const char* name); //returns the type of the element with the given name, or -1 if there isn't one
+Uint32 hash_elements(); //returns a hash of the name of every element in order, for checking that two processes loaded the same elements
\ No newline at end of file
@@ -0,0 +1,268 @@
+#include "frame_export.h"
+#include "simulation.h"
+#include "elements.h"
+#include "lockfree.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+//global vars:
+static std::thread exportThread; //the thread encoding and writing captured frames
+static std::atomic<bool> exportRunning; //whether or not the writer should keep waiting for frames
+static std::mutex exportMutex; //only used to sleep on exportSignal and slotSignal
+static std::condition_variable exportSignal; //wakes the writer when a frame is queued or it should stop
+static std::condition_variable slotSignal; //wakes the simulation when the writer frees a slot, if it waits for the writer
+
+static std::vector<Uint8> slots; //EXPORT_QUEUE_SIZE type planes, the only memory frames are captured into
+static SpscQueue<int, EXPORT_QUEUE_SIZE + 1> freeSlots; //slots the simulation can capture into, passed back from the writer
+static SpscQueue<int, EXPORT_QUEUE_SIZE + 1> fullSlots; //captured slots waiting to be written, passed from the simulation to the writer
+
+static SDL_RWops* exportFile; //the file being written, NULL when writing to stdout
+static ExportFormat exportFormat;
+static int exportInterval;
+static double exportFrameRate;
+static bool exportWaits; //whether or not the simulation waits for a free slot instead of dropping frames
+static Uint64 framesWritten;
+static std::atomic<Uint64> framesDropped;
+
+static Uint8 colors[MAX_PARTICLE_TYPES][3]; //the bytes written for every particle type, rgb or yuv depending on the format
+
+//---------------------------------------------------------------//
+
+void export_thread_loop(); //the main loop of the writer
+void encode_frame(const Uint8* types, std::vector<Uint8>* data); //appends a captured frame to data in the export format
+bool write_output(const std::vector<Uint8>& data); //writes data to the export file or stdout; returns true on success, false on failure
+void rgb_to_yuv(SDL_Color color, Uint8* yuv); //converts a color to limited range bt.601 y, cb, cr
+
+bool start_export(const char* path, ExportFormat format, int interval, double frameRate, bool waitForWriter)
+{
+	if (exportThread.joinable() || interval < 1)
+		return false;
+
+	if (strcmp(path, "-") == 0)
+	{
+		exportFile = NULL;
+#ifdef _WIN32
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+	}
+	else
+	{
+		exportFile = SDL_RWFromFile(path, "wb");
+		if (!exportFile)
+			return false;
+	}
+
+	exportFormat = format;
+	exportInterval = interval;
+	exportFrameRate = frameRate;
+	exportWaits = waitForWriter;
+	framesWritten = 0;
+	framesDropped = 0;
+
+	for (int i = 0; i < elements.count; i++)
+	{
+		if (format == ExportFormat::y4m)
+			rgb_to_yuv(elements.color[i], colors[i]);
+		else
+		{
+			colors[i][0] = elements.color[i].r;
+			colors[i][1] = elements.color[i].g;
+			colors[i][2] = elements.color[i].b;
+		}
+	}
+
+	slots.resize((size_t)EXPORT_QUEUE_SIZE * WIDTH * HEIGHT);
+	for (int i = 0; i < EXPORT_QUEUE_SIZE; i++)
+		freeSlots.push(i);
+
+	exportRunning = true;
+	exportThread = std::thread(export_thread_loop);
+
+	return exportThread.joinable();
+}
+
+ExportStats stop_export()
+{
+	ExportStats stats;
+	stats.written = 0;
+	stats.dropped = 0;
+
+	if (!exportThread.joinable())
+		return stats;
+
+	exportRunning = false;
+	exportSignal.notify_one();
+	exportThread.join();
+
+	if (exportFile)
+		SDL_RWclose(exportFile);
+	else
+		fflush(stdout);
+
+	//leave the queues empty for the next export:
+	int slot;
+	while (freeSlots.pop(slot));
+	while (fullSlots.pop(slot));
+
+	stats.written = framesWritten;
+	stats.dropped = framesDropped;
+	return stats;
+}
+
+void update_export(Uint64 tick, const Particle* cells)
+{
+	if (!exportThread.joinable() || tick % exportInterval != 0)
+		return;
+
+	//drop the frame rather than wait if the writer has fallen behind, unless nothing is waiting on the simulation:
+	int slot;
+	while (!freeSlots.pop(slot))
+	{
+		if (!exportWaits)
+		{
+			framesDropped++;
+			return;
+		}
+
+		//the timeout covers a slot freed between the pop and the wait:
+		std::unique_lock<std::mutex> lock(exportMutex);
+		slotSignal.wait_for(lock, std::chrono::milliseconds(5));
+	}
+
+	Uint8* types = &slots[(size_t)slot * WIDTH * HEIGHT];
+	for (int i = 0; i < WIDTH * HEIGHT; i++)
+		types[i] = (Uint8)cells[i].type;
+
+	fullSlots.push(slot);
+	exportSignal.notify_one();
+}
+
+bool parse_export_format(const char* name, ExportFormat* format)
+{
+	if (strcmp(name, "rgb") == 0)
+		*format = ExportFormat::rgb;
+	else if (strcmp(name, "ppm") == 0)
+		*format = ExportFormat::ppm;
+	else if (strcmp(name, "y4m") == 0)
+		*format = ExportFormat::y4m;
+	else
+		return false;
+
+	return true;
+}
+
+//---------------------------------------------------------------//
+
+void export_thread_loop()
+{
+	std::vector<Uint8> data;
+	bool failed = false;
+
+	//y4m needs a stream header, written once before any frames:
+	if (exportFormat == ExportFormat::y4m)
+	{
+		//the frame rate is stored as a fraction, keep three decimal places of it:
+		std::string header = "YUV4MPEG2 W" + std::to_string(WIDTH) + " H" + std::to_string(HEIGHT) +
+			" F" + std::to_string((long long)(exportFrameRate * 1000.0 + 0.5)) + ":1000 Ip A1:1 C444\n";
+		data.assign(header.begin(), header.end());
+		failed = !write_output(data);
+	}
+
+	while (true)
+	{
+		int slot;
+		if (!fullSlots.pop(slot))
+		{
+			if (!exportRunning)
+				break;
+
+			//sleep until a frame is queued; the timeout covers a notify sent between the pop and the wait:
+			std::unique_lock<std::mutex> lock(exportMutex);
+			exportSignal.wait_for(lock, std::chrono::milliseconds(5));
+			continue;
+		}
+
+		data.clear();
+		encode_frame(&slots[(size_t)slot * WIDTH * HEIGHT], &data);
+		freeSlots.push(slot);
+		slotSignal.notify_one();
+
+		//keep draining the queue after a failed write so the simulation isn't left dropping frames for nothing:
+		if (!failed && write_output(data))
+			framesWritten++;
+		else if (!failed)
+		{
+			failed = true;
+			std::cout << "failed to write exported frames, the rest will be discarded" << std::endl;
+		}
+	}
+}
+
+void encode_frame(const Uint8* types, std::vector<Uint8>* data)
+{
+	const int count = WIDTH * HEIGHT;
+
+	switch (exportFormat)
+	{
+	case ExportFormat::ppm:
+	{
+		std::string header = "P6\n" + std::to_string(WIDTH) + " " + std::to_string(HEIGHT) + "\n255\n";
+		data->insert(data->end(), header.begin(), header.end());
+	}
+	//fall through - the pixels are plain rgb
+	case ExportFormat::rgb:
+	{
+		size_t start = data->size();
+		data->resize(start + (size_t)count * 3);
+
+		Uint8* out = &(*data)[start];
+		for (int i = 0; i < count; i++, out += 3)
+			memcpy(out, colors[types[i]], 3);
+		break;
+	}
+	case ExportFormat::y4m:
+	{
+		const char frameHeader[] = "FRAME\n";
+		data->insert(data->end(), frameHeader, frameHeader + sizeof(frameHeader) - 1);
+
+		//planar: every y, then every cb, then every cr:
+		size_t start = data->size();
+		data->resize(start + (size_t)count * 3);
+
+		Uint8* out = &(*data)[start];
+		for (int plane = 0; plane < 3; plane++)
+			for (int i = 0; i < count; i++)
+				*out++ = colors[types[i]][plane];
+		break;
+	}
+	}
+}
+
+bool write_output(const std::vector<Uint8>& data)
+{
+	if (exportFile)
+		return SDL_RWwrite(exportFile, data.data(), 1, data.size()) == data.size();
+
+	return fwrite(data.data(), 1, data.size(), stdout) == data.size();
+}
+
+void rgb_to_yuv(SDL_Color color, Uint8* yuv)
+{
+	double r = color.r, g = color.g, b = color.b;
+	yuv[0] = (Uint8)(16.0 + (65.481 * r + 128.553 * g + 24.966 * b) / 255.0 + 0.5);
+	yuv[1] = (Uint8)(128.0 + (-37.797 * r - 74.203 * g + 112.0 * b) / 255.0 + 0.5);
+	yuv[2] = (Uint8)(128.0 + (112.0 * r - 93.786 * g - 18.214 * b) / 255.0 + 0.5);
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+#include "particles.h"
+
+//export constants:
+#define EXPORT_QUEUE_SIZE 64 //the most captured frames waiting to be written, frames captured while the queue is full are dropped unless the export waits for the writer
+#define DEFAULT_EXPORT_INTERVAL 1 //the default number of ticks between exported frames
+
+enum class ExportFormat //represents all of the formats frames can be exported in
+{
+	rgb, //headerless 24 bit rgb frames, one after another
+	ppm, //a binary ppm image per frame, one after another
+	y4m //a yuv4mpeg2 stream with full resolution chroma, readable by most video tools
+};
+
+struct ExportStats //the results of exporting frames
+{
+	Uint64 written;
+	Uint64 dropped; //frames skipped because the writer fell behind
+};
+
+//---------------------------------------------------------------//
+
+bool start_export(const char* path, ExportFormat format, int interval, double frameRate, bool waitForWriter); //starts writing every interval-th tick to the given file, or to stdout if path is "-", on a background thread; frameRate is only recorded in formats that have one; waitForWriter makes the simulation wait for a free slot instead of dropping frames, for runs without a real-time deadline; returns true on success, false on failure
+ExportStats stop_export(); //writes out the frames still queued, stops the background thread and returns how many frames were written and dropped
+void update_export(Uint64 tick, const Particle* cells); //queues the cells' types for writing if the tick is due; only waits on the writer if the export was started with waitForWriter; only call from the thread running the simulation, after each tick
+bool parse_export_format(const char* name, ExportFormat* format); //sets the format from its name; returns true on success, false if the name isn't rgb, ppm or y4m
\ No newline at end of file
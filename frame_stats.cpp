@@ -0,0 +1,284 @@
+#include "frame_stats.h"
+#include "simulation.h"
+#include "elements.h"
+#include "lockfree.h"
+#include "byte_io.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct TickRow //everything logged for a single tick
+{
+	Uint64 tick;
+	Uint32* counts; //the number of particles of every type, points into batchCounts
+	TickCounters counters;
+	float phaseTimes[PHASE_COUNT];
+};
+
+//global vars:
+TickCounters tickCounters;
+
+static std::thread statsThread; //the thread formatting and writing batches
+static std::atomic<bool> statsRunning; //whether or not the writer should keep waiting for batches
+static std::mutex statsMutex; //only used to sleep on statsSignal
+static std::condition_variable statsSignal; //wakes the writer when a batch is queued or it should stop
+
+static std::vector<TickRow> batches; //STATS_QUEUE_SIZE batches of STATS_BATCH_SIZE rows, the only memory ticks are logged into
+static std::vector<Uint32> batchCounts; //the particle counts of every row, typeCount per row, sized for the elements in use rather than every possible type
+static int typeCount; //the number of particle types counted in every row
+static int batchSizes[STATS_QUEUE_SIZE]; //the number of rows filled in every batch
+static SpscQueue<int, STATS_QUEUE_SIZE + 1> freeBatches; //batches the simulation can fill, passed back from the writer
+static SpscQueue<int, STATS_QUEUE_SIZE + 1> fullBatches; //filled batches waiting to be written, passed from the simulation to the writer
+static int currentBatch = -1; //the batch being filled by the simulation, -1 if none
+
+static SDL_RWops* statsFile;
+static StatsFormat statsFormat;
+static Uint64 ticksWritten;
+static Uint64 ticksDropped;
+
+static const char* REACTION_NAMES[REACTION_COUNT] = { "lava_to_stone", "water_to_steam", "acid_to_toxic_gas", "ignitions" };
+static const char* PHASE_NAMES[PHASE_COUNT] = { "commands_ms", "simulate_ms", "history_ms", "output_ms" };
+
+//---------------------------------------------------------------//
+
+void stats_thread_loop(); //the main loop of the writer
+void encode_header(std::vector<Uint8>* data); //appends the start of the log to data in the stats format
+void encode_row(const TickRow& row, std::vector<Uint8>* data); //appends a row to data in the stats format
+void append_text(const char* text, std::vector<Uint8>* data); //appends text to data without its terminator
+
+bool start_stats_log(const char* path, StatsFormat format)
+{
+	if (statsThread.joinable())
+		return false;
+
+	statsFile = SDL_RWFromFile(path, "wb");
+	if (!statsFile)
+		return false;
+
+	statsFormat = format;
+	ticksWritten = 0;
+	ticksDropped = 0;
+	tickCounters = TickCounters();
+
+	typeCount = elements.count;
+	batches.resize((size_t)STATS_QUEUE_SIZE * STATS_BATCH_SIZE);
+	batchCounts.resize(batches.size() * typeCount);
+	for (size_t i = 0; i < batches.size(); i++)
+		batches[i].counts = &batchCounts[i * typeCount];
+	for (int i = 0; i < STATS_QUEUE_SIZE; i++)
+		freeBatches.push(i);
+	currentBatch = -1;
+
+	statsRunning = true;
+	statsThread = std::thread(stats_thread_loop);
+
+	return statsThread.joinable();
+}
+
+StatsLogStats stop_stats_log()
+{
+	StatsLogStats stats;
+	stats.written = 0;
+	stats.dropped = 0;
+
+	if (!statsThread.joinable())
+		return stats;
+
+	//hand over the partly filled batch, the simulation has stopped adding to it:
+	if (currentBatch >= 0)
+		fullBatches.push(currentBatch);
+	currentBatch = -1;
+
+	statsRunning = false;
+	statsSignal.notify_one();
+	statsThread.join();
+
+	SDL_RWclose(statsFile);
+
+	//leave the queues empty for the next log:
+	int batch;
+	while (freeBatches.pop(batch));
+	while (fullBatches.pop(batch));
+
+	stats.written = ticksWritten;
+	stats.dropped = ticksDropped;
+	return stats;
+}
+
+void update_stats_log(Uint64 tick, const double* phaseTimes)
+{
+	if (!statsThread.joinable())
+	{
+		tickCounters = TickCounters();
+		return;
+	}
+
+	//drop the tick rather than wait if the writer has fallen behind:
+	if (currentBatch < 0)
+	{
+		if (!freeBatches.pop(currentBatch))
+		{
+			currentBatch = -1;
+			ticksDropped++;
+			tickCounters = TickCounters();
+			return;
+		}
+
+		batchSizes[currentBatch] = 0;
+	}
+
+	TickRow& row = batches[(size_t)currentBatch * STATS_BATCH_SIZE + batchSizes[currentBatch]];
+	row.tick = tick;
+	memcpy(row.counts, get_populations(), sizeof(Uint32) * typeCount);
+	row.counters = tickCounters;
+	for (int i = 0; i < PHASE_COUNT; i++)
+		row.phaseTimes[i] = (float)phaseTimes[i];
+
+	tickCounters = TickCounters();
+
+	if (++batchSizes[currentBatch] == STATS_BATCH_SIZE)
+	{
+		fullBatches.push(currentBatch);
+		currentBatch = -1;
+		statsSignal.notify_one();
+	}
+}
+
+bool stats_logging()
+{
+	return statsThread.joinable();
+}
+
+bool parse_stats_format(const char* name, StatsFormat* format)
+{
+	if (strcmp(name, "csv") == 0)
+		*format = StatsFormat::csv;
+	else if (strcmp(name, "binary") == 0)
+		*format = StatsFormat::binary;
+	else
+		return false;
+
+	return true;
+}
+
+//---------------------------------------------------------------//
+
+void stats_thread_loop()
+{
+	std::vector<Uint8> data;
+	encode_header(&data);
+	bool failed = SDL_RWwrite(statsFile, data.data(), 1, data.size()) != data.size();
+
+	while (true)
+	{
+		int batch;
+		if (!fullBatches.pop(batch))
+		{
+			if (!statsRunning)
+				break;
+
+			//sleep until a batch is queued; the timeout covers a notify sent between the pop and the wait:
+			std::unique_lock<std::mutex> lock(statsMutex);
+			statsSignal.wait_for(lock, std::chrono::milliseconds(50));
+			continue;
+		}
+
+		//format the whole batch and write it at once:
+		data.clear();
+		const TickRow* rows = &batches[(size_t)batch * STATS_BATCH_SIZE];
+		int count = batchSizes[batch];
+		for (int i = 0; i < count; i++)
+			encode_row(rows[i], &data);
+		freeBatches.push(batch);
+
+		//keep draining the queue after a failed write so the simulation isn't left dropping ticks for nothing:
+		if (!failed && SDL_RWwrite(statsFile, data.data(), 1, data.size()) == data.size())
+			ticksWritten += count;
+		else if (!failed)
+		{
+			failed = true;
+			std::cout << "failed to write stats, the rest will be discarded" << std::endl;
+		}
+	}
+}
+
+void encode_header(std::vector<Uint8>* data)
+{
+	if (statsFormat == StatsFormat::binary)
+	{
+		write_u32(STATS_MAGIC, data);
+		write_u16(STATS_VERSION, data);
+		write_u16((Uint16)typeCount, data);
+		write_u8(REACTION_COUNT, data);
+		write_u8(PHASE_COUNT, data);
+		return;
+	}
+
+	std::string header = "tick";
+	for (int i = 0; i < typeCount; i++)
+		header += std::string(",") + elements.name[i];
+	header += ",swaps,updated";
+	for (int i = 0; i < REACTION_COUNT; i++)
+		header += std::string(",") + REACTION_NAMES[i];
+	for (int i = 0; i < PHASE_COUNT; i++)
+		header += std::string(",") + PHASE_NAMES[i];
+	header += "\n";
+
+	append_text(header.c_str(), data);
+}
+
+void encode_row(const TickRow& row, std::vector<Uint8>* data)
+{
+	if (statsFormat == StatsFormat::binary)
+	{
+		write_u64(row.tick, data);
+		for (int i = 0; i < typeCount; i++)
+			write_u32(row.counts[i], data);
+		write_u32(row.counters.swaps, data);
+		write_u32(row.counters.updated, data);
+		for (int i = 0; i < REACTION_COUNT; i++)
+			write_u32(row.counters.reactions[i], data);
+		for (int i = 0; i < PHASE_COUNT; i++)
+			write_f32(row.phaseTimes[i], data);
+		return;
+	}
+
+	char text[32];
+	snprintf(text, sizeof(text), "%llu", (unsigned long long)row.tick);
+	append_text(text, data);
+
+	for (int i = 0; i < typeCount; i++)
+	{
+		snprintf(text, sizeof(text), ",%u", (unsigned int)row.counts[i]);
+		append_text(text, data);
+	}
+
+	snprintf(text, sizeof(text), ",%u,%u", (unsigned int)row.counters.swaps, (unsigned int)row.counters.updated);
+	append_text(text, data);
+
+	for (int i = 0; i < REACTION_COUNT; i++)
+	{
+		snprintf(text, sizeof(text), ",%u", (unsigned int)row.counters.reactions[i]);
+		append_text(text, data);
+	}
+
+	for (int i = 0; i < PHASE_COUNT; i++)
+	{
+		snprintf(text, sizeof(text), ",%.4f", row.phaseTimes[i]);
+		append_text(text, data);
+	}
+
+	data->push_back('\n');
+}
+
+void append_text(const char* text, std::vector<Uint8>* data)
+{
+	data->insert(data->end(), text, text + strlen(text));
+}
\ No newline at end of file
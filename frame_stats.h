@@ -0,0 +1,64 @@
+#pragma once
+#include "particles.h"
+
+//stats constants:
+#define STATS_MAGIC 0x54535345 //"ESST" when written in little-endian byte order
+#define STATS_VERSION 2
+#define STATS_BATCH_SIZE 4096 //the number of ticks collected before they are handed to the writer together
+#define STATS_QUEUE_SIZE 16 //the most batches waiting to be written, ticks collected while every batch is full are dropped
+#define REACTION_COUNT 4
+#define PHASE_COUNT 4
+
+//binary stats logs are a u32 magic, u16 version, u16 particle type count, u8 reaction count and u8 phase count,
+//followed by one fixed size row per tick: u64 tick, u32 count of every particle type, u32 swaps, u32 cells updated,
+//u32 count of every reaction and f32 time of every phase in milliseconds, all little-endian
+
+enum class StatsFormat //represents all of the formats stats can be logged in
+{
+	csv, //a header line, then a line per tick
+	binary //fixed size rows, see above
+};
+
+enum class Reaction //represents all of the reactions counted in the stats
+{
+	lavaToStone,
+	waterToSteam,
+	acidToToxicGas,
+	ignition
+};
+
+enum class TickPhase //represents all of the timed parts of a tick
+{
+	commands, //applying input
+	simulate, //running the simulation
+	history, //keeping rewind history
+	output //autosaving and exporting
+};
+
+struct TickCounters //counted by the simulation during a tick
+{
+	Uint32 swaps;
+	Uint32 updated; //cells whose update function ran
+	Uint32 reactions[REACTION_COUNT];
+};
+
+struct StatsLogStats //the results of logging stats
+{
+	Uint64 written; //ticks written
+	Uint64 dropped; //ticks skipped because the writer fell behind
+};
+
+extern TickCounters tickCounters; //the counters for the tick in progress, reset by update_stats_log()
+
+//---------------------------------------------------------------//
+
+bool start_stats_log(const char* path, StatsFormat format); //starts writing stats for every tick to the given file, in batches on a background thread; returns true on success, false on failure
+StatsLogStats stop_stats_log(); //writes out the ticks still queued, stops the background thread and returns how many ticks were written and dropped
+void update_stats_log(Uint64 tick, const double* phaseTimes); //logs the tick's populations, counters and PHASE_COUNT phase times in milliseconds, then resets the counters; never waits on the writer; only call from the thread running the simulation, after each tick
+bool stats_logging(); //returns true if stats are being logged, false otherwise
+bool parse_stats_format(const char* name, StatsFormat* format); //sets the format from its name; returns true on success, false if the name isn't csv or binary
+
+inline void count_reaction(Reaction reaction) //counts a reaction for the tick in progress
+{
+	tickCounters.reactions[(int)reaction]++;
+}
\ No newline at end of file
@@ -0,0 +1,473 @@
+#include "frame_stream.h"
+#include "elements.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <afunix.h>
+typedef SOCKET Socket;
+#define NO_SOCKET INVALID_SOCKET
+#else
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+typedef int Socket;
+#define NO_SOCKET -1
+#endif
+
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL //report a closed connection as an error instead of raising SIGPIPE
+#else
+#define SEND_FLAGS 0
+#endif
+
+#define RECEIVE_CHUNK_SIZE 65536 //the most bytes read from a socket at once
+#define NO_TYPE 0xFF //matches no particle type, for sending the first frame in full; MAX_ELEMENTS keeps it free
+
+//global vars:
+static Socket listenSocket = NO_SOCKET; //the server's listening socket
+static Socket viewerSocket = NO_SOCKET; //the server's connection to its viewer
+static std::vector<Uint8> viewerInbox; //bytes received from the viewer that don't make up a whole message yet
+static std::vector<Uint8> sentTypes; //the last frame sent to the viewer, which the next one is encoded against
+static Uint64 lastSentTick;
+static Uint64 bytesSent;
+static std::string serverPath;
+
+static Socket serverSocket = NO_SOCKET; //the viewer's connection to the server
+static std::vector<Uint8> serverInbox; //bytes received from the server that don't make up a whole message yet
+static bool helloReceived;
+
+//---------------------------------------------------------------//
+
+bool init_sockets(); //starts up the socket library where needed; returns true on success, false on failure
+bool make_address(const char* path, sockaddr_un* address); //fills in a unix socket address; returns false if the path is too long
+bool remove_stale_socket(const char* path); //removes a socket file left at the path; returns true if the path is now free, false if something other than a socket is there
+void close_socket(Socket* socket); //closes a socket and marks it closed
+bool socket_readable(Socket socket); //returns true if reading from the socket won't block
+bool send_all(Socket socket, const std::vector<Uint8>& data); //sends every byte; returns true on success, false if the connection was lost
+bool receive_some(Socket socket, std::vector<Uint8>* inbox); //appends whatever has arrived to inbox; returns true on success, false if the connection was lost
+size_t begin_message(StreamMessage message, std::vector<Uint8>* data); //writes a message header with a placeholder length; returns where the message starts
+void end_message(size_t start, std::vector<Uint8>* data); //fills in the length of the message that started at start
+bool next_message(std::vector<Uint8>* inbox, size_t* pos, ByteReader* message); //points message at the next whole message in inbox past pos and moves pos past it; returns false if there is no whole message yet or the stream is corrupt
+
+bool start_stream_server(const char* path)
+{
+	sockaddr_un address;
+	if (!init_sockets() || !make_address(path, &address))
+		return false;
+
+	//remove a socket file left behind by a server that didn't shut down cleanly, but never anything else:
+	if (!remove_stale_socket(path))
+	{
+		std::cout << "address in use: " << path << " exists and is not a socket" << std::endl;
+		return false;
+	}
+
+	listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listenSocket == NO_SOCKET)
+		return false;
+
+	if (bind(listenSocket, (sockaddr*)&address, sizeof(address)) != 0 || listen(listenSocket, 1) != 0)
+	{
+		close_socket(&listenSocket);
+		return false;
+	}
+
+	serverPath = path;
+	bytesSent = 0;
+	return true;
+}
+
+void update_stream_server(const FrameSnapshot& frame)
+{
+	const int count = WIDTH * HEIGHT;
+
+	//accept a viewer and greet it:
+	if (viewerSocket == NO_SOCKET && listenSocket != NO_SOCKET && socket_readable(listenSocket))
+	{
+		viewerSocket = accept(listenSocket, NULL, NULL);
+		if (viewerSocket == NO_SOCKET)
+			return;
+
+		std::vector<Uint8> hello;
+		size_t start = begin_message(StreamMessage::hello, &hello);
+		write_u32(STREAM_MAGIC, &hello);
+		write_u16(STREAM_VERSION, &hello);
+		write_u32(WIDTH, &hello);
+		write_u32(HEIGHT, &hello);
+		write_u16((Uint16)elements.count, &hello);
+		write_u32(hash_elements(), &hello);
+		end_message(start, &hello);
+
+		viewerInbox.clear();
+		sentTypes.assign(count, NO_TYPE);
+		lastSentTick = 0;
+
+		if (!send_all(viewerSocket, hello))
+			close_socket(&viewerSocket);
+		else
+			std::cout << "viewer connected" << std::endl;
+	}
+
+	if (viewerSocket == NO_SOCKET)
+		return;
+
+	//pass the viewer's commands on to the simulation thread:
+	bool connected = !socket_readable(viewerSocket) || receive_some(viewerSocket, &viewerInbox);
+
+	size_t pos = 0;
+	ByteReader message;
+	while (connected && next_message(&viewerInbox, &pos, &message))
+	{
+		if ((StreamMessage)read_u8(&message) != StreamMessage::command)
+			continue;
+
+		SimCommand command;
+		command.type = (CommandType)read_u8(&message);
+		command.particleType = (ParticleType)read_u8(&message);
+		command.brushSize = read_u8(&message);
+		command.x = (int)read_zigzag(&message);
+		command.y = (int)read_zigzag(&message);
+		command.id = read_varint(&message);
+		command.inputTime = std::chrono::steady_clock::now();
+
+		if (!message.failed && (int)command.type <= (int)CommandType::rewind && (int)command.particleType < elements.count && command.brushSize <= 2)
+			push_command(command);
+	}
+	viewerInbox.erase(viewerInbox.begin(), viewerInbox.begin() + pos);
+	if (viewerInbox.size() > STREAM_MAX_MESSAGE_SIZE + 5)
+		connected = false;
+
+	//send the frame if it is new, as only the cells that changed since the last one sent:
+	if (connected && frame.tick != lastSentTick)
+	{
+		std::vector<Uint8> data;
+		size_t start = begin_message(StreamMessage::frame, &data);
+		write_varint(frame.tick, &data);
+		write_varint(frame.lastCommand, &data);
+		encode_frame_delta(sentTypes.data(), frame.types, count, &data);
+		end_message(start, &data);
+
+		connected = send_all(viewerSocket, data);
+		memcpy(sentTypes.data(), frame.types, count);
+		lastSentTick = frame.tick;
+		bytesSent += data.size();
+	}
+
+	if (!connected)
+	{
+		close_socket(&viewerSocket);
+		std::cout << "viewer disconnected" << std::endl;
+	}
+}
+
+void stop_stream_server()
+{
+	close_socket(&viewerSocket);
+	if (listenSocket == NO_SOCKET)
+		return;
+
+	close_socket(&listenSocket);
+	remove(serverPath.c_str());
+}
+
+Uint64 get_stream_bytes_sent()
+{
+	return bytesSent;
+}
+
+bool connect_stream(const char* path)
+{
+	sockaddr_un address;
+	if (!init_sockets() || !make_address(path, &address))
+		return false;
+
+	serverSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (serverSocket == NO_SOCKET)
+		return false;
+
+	if (connect(serverSocket, (sockaddr*)&address, sizeof(address)) != 0)
+	{
+		close_socket(&serverSocket);
+		return false;
+	}
+
+	serverInbox.clear();
+	helloReceived = false;
+	return true;
+}
+
+bool update_stream_client(FrameSnapshot* frame)
+{
+	if (serverSocket == NO_SOCKET)
+		return false;
+
+	if (socket_readable(serverSocket) && !receive_some(serverSocket, &serverInbox))
+	{
+		disconnect_stream();
+		return false;
+	}
+
+	//apply every whole message, frames in order since each is a delta against the last:
+	bool valid = true;
+	size_t pos = 0;
+	ByteReader message;
+	while (valid && next_message(&serverInbox, &pos, &message))
+	{
+		StreamMessage type = (StreamMessage)read_u8(&message);
+		if (type == StreamMessage::hello)
+		{
+			valid = read_u32(&message) == STREAM_MAGIC && read_u16(&message) == STREAM_VERSION &&
+				read_u32(&message) == WIDTH && read_u32(&message) == HEIGHT && !message.failed;
+
+			//frames and commands refer to elements by number, so both ends need the same ones:
+			if (valid && (read_u16(&message) != elements.count || read_u32(&message) != hash_elements() || message.failed))
+			{
+				std::cout << "the server was started with different elements, load the same --elements file" << std::endl;
+				valid = false;
+			}
+			helloReceived = valid;
+		}
+		else if (type == StreamMessage::frame && helloReceived)
+		{
+			frame->tick = read_varint(&message);
+			frame->lastCommand = read_varint(&message);
+			valid = apply_frame_delta(&message, frame->types, WIDTH * HEIGHT);
+		}
+		else
+			valid = false;
+	}
+	serverInbox.erase(serverInbox.begin(), serverInbox.begin() + pos);
+
+	if (!valid || serverInbox.size() > STREAM_MAX_MESSAGE_SIZE + 5)
+	{
+		disconnect_stream();
+		return false;
+	}
+
+	return true;
+}
+
+bool send_stream_command(const SimCommand& command)
+{
+	if (serverSocket == NO_SOCKET)
+		return false;
+
+	std::vector<Uint8> data;
+	size_t start = begin_message(StreamMessage::command, &data);
+	write_u8((Uint8)command.type, &data);
+	write_u8((Uint8)command.particleType, &data);
+	write_u8((Uint8)command.brushSize, &data);
+	write_zigzag(command.x, &data);
+	write_zigzag(command.y, &data);
+	write_varint(command.id, &data);
+	end_message(start, &data);
+
+	if (send_all(serverSocket, data))
+		return true;
+
+	disconnect_stream();
+	return false;
+}
+
+bool stream_connected()
+{
+	return serverSocket != NO_SOCKET;
+}
+
+void disconnect_stream()
+{
+	close_socket(&serverSocket);
+}
+
+void encode_frame_delta(const Uint8* previous, const Uint8* current, int count, std::vector<Uint8>* data)
+{
+	//find the runs first so their count can lead:
+	static std::vector<int> runs; //(start, length) pairs
+	runs.clear();
+
+	for (int i = 0; i < count;)
+	{
+		if (current[i] == previous[i])
+		{
+			i++;
+			continue;
+		}
+
+		int length = 1;
+		while (i + length < count && current[i + length] != previous[i + length] && current[i + length] == current[i])
+			length++;
+
+		runs.push_back(i);
+		runs.push_back(length);
+		i += length;
+	}
+
+	write_varint(runs.size() / 2, data);
+
+	int next = 0; //the index the next run's skip is measured from
+	for (size_t i = 0; i < runs.size(); i += 2)
+	{
+		write_varint(runs[i] - next, data);
+		write_varint(runs[i + 1], data);
+		write_u8(current[runs[i]], data);
+		next = runs[i] + runs[i + 1];
+	}
+}
+
+bool apply_frame_delta(ByteReader* reader, Uint8* types, int count)
+{
+	Uint64 runs = read_varint(reader);
+
+	Uint64 idx = 0;
+	for (Uint64 i = 0; i < runs && !reader->failed; i++)
+	{
+		Uint64 skip = read_varint(reader);
+		Uint64 length = read_varint(reader);
+		Uint8 type = read_u8(reader);
+		if (reader->failed || type >= elements.count || skip > count - idx || length > count - idx - skip)
+			return false;
+
+		memset(types + idx + skip, type, (size_t)length);
+		idx += skip + length;
+	}
+
+	return !reader->failed;
+}
+
+//---------------------------------------------------------------//
+
+bool init_sockets()
+{
+#ifdef _WIN32
+	static bool started = false;
+	if (!started)
+	{
+		WSADATA data;
+		started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+	}
+
+	return started;
+#else
+	return true;
+#endif
+}
+
+bool make_address(const char* path, sockaddr_un* address)
+{
+	memset(address, 0, sizeof(*address));
+	address->sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(address->sun_path))
+		return false;
+
+	memcpy(address->sun_path, path, strlen(path));
+	return true;
+}
+
+bool remove_stale_socket(const char* path)
+{
+#ifdef _WIN32
+	//unix sockets show up as reparse points on windows:
+	DWORD attributes = GetFileAttributesA(path);
+	if (attributes == INVALID_FILE_ATTRIBUTES)
+		return GetLastError() == ERROR_FILE_NOT_FOUND || GetLastError() == ERROR_PATH_NOT_FOUND;
+	if (!(attributes & FILE_ATTRIBUTE_REPARSE_POINT) || (attributes & FILE_ATTRIBUTE_DIRECTORY))
+		return false;
+
+	return DeleteFileA(path) != 0;
+#else
+	struct stat info;
+	if (lstat(path, &info) != 0)
+		return errno == ENOENT;
+	if (!S_ISSOCK(info.st_mode))
+		return false;
+
+	return unlink(path) == 0;
+#endif
+}
+
+void close_socket(Socket* socket)
+{
+	if (*socket == NO_SOCKET)
+		return;
+
+#ifdef _WIN32
+	closesocket(*socket);
+#else
+	close(*socket);
+#endif
+
+	*socket = NO_SOCKET;
+}
+
+bool socket_readable(Socket socket)
+{
+	fd_set sockets;
+	FD_ZERO(&sockets);
+	FD_SET(socket, &sockets);
+
+	timeval timeout = {};
+	return select((int)socket + 1, &sockets, NULL, NULL, &timeout) > 0;
+}
+
+bool send_all(Socket socket, const std::vector<Uint8>& data)
+{
+	size_t sent = 0;
+	while (sent < data.size())
+	{
+		int result = send(socket, (const char*)data.data() + sent, (int)(data.size() - sent), SEND_FLAGS);
+		if (result <= 0)
+			return false;
+
+		sent += result;
+	}
+
+	return true;
+}
+
+bool receive_some(Socket socket, std::vector<Uint8>* inbox)
+{
+	size_t start = inbox->size();
+	inbox->resize(start + RECEIVE_CHUNK_SIZE);
+
+	int result = recv(socket, (char*)inbox->data() + start, RECEIVE_CHUNK_SIZE, 0);
+	inbox->resize(start + (result > 0 ? result : 0));
+
+	return result > 0;
+}
+
+size_t begin_message(StreamMessage message, std::vector<Uint8>* data)
+{
+	size_t start = data->size();
+	write_u32(0, data);
+	write_u8((Uint8)message, data);
+
+	return start;
+}
+
+void end_message(size_t start, std::vector<Uint8>* data)
+{
+	Uint32 length = (Uint32)(data->size() - start - 4);
+	for (int i = 0; i < 4; i++)
+		(*data)[start + i] = (Uint8)(length >> (i * 8));
+}
+
+bool next_message(std::vector<Uint8>* inbox, size_t* pos, ByteReader* message)
+{
+	ByteReader header = make_byte_reader(inbox->data() + *pos, inbox->size() - *pos);
+	Uint32 length = read_u32(&header);
+	if (header.failed || length > STREAM_MAX_MESSAGE_SIZE || length > header.size - header.pos)
+		return false;
+
+	*message = make_byte_reader(inbox->data() + *pos + 4, length);
+	*pos += 4 + length;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+#include "sim_thread.h"
+#include "byte_io.h"
+#include <vector>
+
+//frame stream constants:
+#define STREAM_MAGIC 0x53535345 //"ESSS" when written in little-endian byte order
+#define STREAM_VERSION 2
+#define STREAM_MAX_MESSAGE_SIZE (1 << 20) //messages claiming to be larger than this are treated as a broken connection
+
+//stream protocol, all integers little-endian and varints in LEB128, every message prefixed with its u32 length and a u8 StreamMessage:
+//  hello (server to viewer, first): u32 magic, u16 version, u32 width, u32 height, u16 element count, u32 hash of the element names
+//  frame (server to viewer): varint tick, varint lastCommand, then the frame as a delta against the one sent before it
+//  command (viewer to server): u8 command type, u8 particle type, u8 brush size, zigzag varint x, zigzag varint y, varint id
+//frame deltas are a varint run count followed by runs of (varint unchanged cells skipped, varint changed cells, u8 their new type);
+//a run only covers cells that all changed to the same type, and the first frame is sent against a plane that matches nothing
+
+enum class StreamMessage //represents all of the messages sent over a frame stream
+{
+	hello,
+	frame,
+	command
+};
+
+//---------------------------------------------------------------//
+
+bool start_stream_server(const char* path); //starts listening for a viewer on the given unix socket path; returns true on success, false on failure
+void update_stream_server(const FrameSnapshot& frame); //accepts a viewer if none is connected, queues its commands for the simulation thread and sends it the frame if it is new
+void stop_stream_server(); //disconnects the viewer and stops listening
+Uint64 get_stream_bytes_sent(); //returns the number of bytes sent to viewers so far
+
+bool connect_stream(const char* path); //connects to a server on the given unix socket path; returns true on success, false on failure
+bool update_stream_client(FrameSnapshot* frame); //applies every frame received from the server to frame; returns false if the connection was lost
+bool send_stream_command(const SimCommand& command); //sends a command to the server; returns false if the connection was lost
+bool stream_connected(); //returns true if connected to a server, false otherwise
+void disconnect_stream(); //closes the connection to the server
+
+void encode_frame_delta(const Uint8* previous, const Uint8* current, int count, std::vector<Uint8>* data); //appends the changes from previous to current to data
+bool apply_frame_delta(ByteReader* reader, Uint8* types, int count); //applies an encoded delta to types; returns true on success, false if the data is corrupt
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "image_import.h"
+#include "simulation.h"
+#include "elements.h"
+#include "byte_io.h"
+#include "SDL_image.h"
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+//---------------------------------------------------------------//
+
+bool read_image_types(const char* path, Uint8* types, int width, int height); //fills a type plane from an image SDL_image can load; returns true on success, false on failure
+bool read_raw_types(const char* path, Uint8* types, int width, int height); //fills a type plane from a raw bitmap of type bytes; returns true on success, false on failure
+ParticleType nearest_type(Uint8 r, Uint8 g, Uint8 b); //returns the element whose color is closest to the given one
+void fill_cells(const Uint8* types, Particle* cells, int width, int height); //fills the cells with new particles of the given types, a run of equal types at a time
+
+bool import_world(const char* path, Particle* cells, int width, int height)
+{
+	//read into a type plane first so a failed import leaves the cells alone:
+	std::vector<Uint8> types((size_t)width * height, (Uint8)ParticleType::empty);
+	if (!read_image_types(path, types.data(), width, height) && !read_raw_types(path, types.data(), width, height))
+		return false;
+
+	fill_cells(types.data(), cells, width, height);
+	return true;
+}
+
+//---------------------------------------------------------------//
+
+bool read_image_types(const char* path, Uint8* types, int width, int height)
+{
+	SDL_Surface* loaded = IMG_Load(path);
+	if (!loaded)
+		return false;
+
+	//convert to a single known layout instead of handling every format the image might come in:
+	SDL_Surface* image = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+	SDL_FreeSurface(loaded);
+	if (!image)
+		return false;
+
+	SDL_LockSurface(image);
+
+	int rows = std::min(height, image->h);
+	int columns = std::min(width, image->w);
+	for (int y = 0; y < rows; y++)
+	{
+		const Uint8* pixel = (const Uint8*)image->pixels + y * image->pitch;
+		Uint8* row = types + y * width;
+
+		//neighboring pixels are usually the same color, so only search the palette when it changes:
+		Uint32 lastColor = 0;
+		Uint8 lastType = (Uint8)ParticleType::empty;
+		for (int x = 0; x < columns; x++, pixel += 4)
+		{
+			if (pixel[3] < IMPORT_ALPHA_THRESHOLD)
+			{
+				row[x] = (Uint8)ParticleType::empty;
+				continue;
+			}
+
+			Uint32 color = pixel[0] | pixel[1] << 8 | pixel[2] << 16 | 0xFF000000;
+			if (color != lastColor)
+			{
+				lastColor = color;
+				lastType = (Uint8)nearest_type(pixel[0], pixel[1], pixel[2]);
+			}
+			row[x] = lastType;
+		}
+	}
+
+	SDL_UnlockSurface(image);
+	SDL_FreeSurface(image);
+	return true;
+}
+
+bool read_raw_types(const char* path, Uint8* types, int width, int height)
+{
+	std::vector<Uint8> data;
+	if (!read_file(path, &data) || data.size() != (size_t)width * height)
+		return false;
+
+	for (Uint8 type : data)
+		if (type >= elements.count)
+			return false;
+
+	std::copy(data.begin(), data.end(), types);
+	return true;
+}
+
+ParticleType nearest_type(Uint8 r, Uint8 g, Uint8 b)
+{
+	int nearest = (int)ParticleType::empty;
+	int nearestDistance = INT_MAX;
+	for (int i = 0; i < elements.count; i++)
+	{
+		int dr = r - elements.color[i].r;
+		int dg = g - elements.color[i].g;
+		int db = b - elements.color[i].b;
+		int distance = dr * dr + dg * dg + db * db;
+		if (distance < nearestDistance)
+		{
+			nearest = i;
+			nearestDistance = distance;
+		}
+	}
+
+	return (ParticleType)nearest;
+}
+
+void fill_cells(const Uint8* types, Particle* cells, int width, int height)
+{
+	Particle prototypes[MAX_PARTICLE_TYPES];
+	for (int i = 0; i < elements.count; i++)
+		prototypes[i] = new_particle((ParticleType)i);
+
+	for (int y = 0; y < height; y++)
+	{
+		const Uint8* row = types + y * width;
+		Particle* cellRow = cells + y * width;
+
+		for (int x = 0; x < width;)
+		{
+			int run = 1;
+			while (x + run < width && row[x + run] == row[x])
+				run++;
+
+			std::fill_n(cellRow + x, run, prototypes[row[x]]);
+			x += run;
+		}
+	}
+}
\ No newline at end of file
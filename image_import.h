@@ -0,0 +1,9 @@
+#pragma once
+#include "particles.h"
+
+//import constants:
+#define IMPORT_ALPHA_THRESHOLD 128 //pixels less opaque than this are imported as empty cells
+
+//---------------------------------------------------------------//
+
+bool import_world(const char* path, Particle* cells, int width, int height); //fills the cells from an image, mapping every pixel to the element with the nearest color, or from a raw bitmap of width * height bytes holding one type per cell; images of a different size are cropped or padded with empty cells; returns true on success, false on failure
\ No newline at end of file
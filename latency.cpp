@@ -0,0 +1,111 @@
+#include "latency.h"
+#include <chrono>
+#include <cstring>
+
+//global vars:
+static SimCommand inputs[INPUT_HISTORY_SIZE]; //ring of recent brush commands, indexed by id
+static Uint64 nextId = 1; //the id of the next tracked input, 0 is reserved for untracked commands
+static Uint64 firstInvisible = 1; //the id of the oldest input that isn't visible yet
+static bool lowLatency;
+
+static int latencySamples;
+static double latencySum;
+static double latencyMax;
+
+//---------------------------------------------------------------//
+
+void preview_brush(Uint8* types, const SimCommand& command); //applies a brush command to a type plane the same way add_particles() applies it to the grid
+
+void track_input(SimCommand* command)
+{
+	command->id = nextId++;
+	command->inputTime = std::chrono::steady_clock::now();
+
+	//forget the oldest input if the ring is full, it will never be measured:
+	if (command->id - firstInvisible >= INPUT_HISTORY_SIZE)
+		firstInvisible = command->id - INPUT_HISTORY_SIZE + 1;
+
+	inputs[command->id % INPUT_HISTORY_SIZE] = *command;
+}
+
+void preview_inputs(const FrameSnapshot& frame, FrameSnapshot* preview)
+{
+	memcpy(preview, &frame, sizeof(FrameSnapshot));
+
+	Uint64 first = frame.lastCommand + 1;
+	if (first < firstInvisible)
+		first = firstInvisible;
+	if (nextId - first > INPUT_HISTORY_SIZE)
+		first = nextId - INPUT_HISTORY_SIZE;
+
+	for (Uint64 id = first; id < nextId; id++)
+	{
+		preview_brush(preview->types, inputs[id % INPUT_HISTORY_SIZE]);
+		preview->lastCommand = id;
+	}
+}
+
+void record_present(Uint64 lastVisible)
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	for (; firstInvisible <= lastVisible && firstInvisible < nextId; firstInvisible++)
+	{
+		double latency = std::chrono::duration<double, std::milli>(now - inputs[firstInvisible % INPUT_HISTORY_SIZE].inputTime).count();
+
+		latencySamples++;
+		latencySum += latency;
+		if (latency > latencyMax)
+			latencyMax = latency;
+	}
+}
+
+LatencyStats get_latency_stats()
+{
+	LatencyStats stats;
+	stats.samples = latencySamples;
+	stats.mean = latencySamples > 0 ? latencySum / latencySamples : 0.0;
+	stats.max = latencyMax;
+
+	return stats;
+}
+
+void reset_latency_stats()
+{
+	latencySamples = 0;
+	latencySum = 0.0;
+	latencyMax = 0.0;
+}
+
+void set_low_latency(bool enabled)
+{
+	lowLatency = enabled;
+}
+
+bool get_low_latency()
+{
+	return lowLatency;
+}
+
+//---------------------------------------------------------------//
+
+void preview_brush(Uint8* types, const SimCommand& command)
+{
+	if (command.type != CommandType::addParticles)
+		return;
+
+	Uint8 type = (Uint8)command.particleType;
+
+	if (command.brushSize == 0)
+	{
+		if (in_bounds(command.x, command.y))
+			types[command.x + command.y * WIDTH] = type;
+
+		return;
+	}
+
+	for (int i = command.x - command.brushSize; i <= command.x + command.brushSize; i++)
+		for (int j = command.y - command.brushSize; j <= command.y + command.brushSize; j++)
+			if (in_bounds(i, j) && (command.particleType == ParticleType::empty || types[i + j * WIDTH] == (Uint8)ParticleType::empty))
+				types[i + j * WIDTH] = type;
+}
\ No newline at end of file
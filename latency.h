@@ -0,0 +1,24 @@
+#pragma once
+#include "sim_thread.h"
+
+//latency constants:
+#define INPUT_HISTORY_SIZE 256 //the number of recent brush commands remembered for measuring latency and drawing the low latency preview
+
+struct LatencyStats //telemetry on the time between sampling a brush input and showing its result
+{
+	int samples; //the number of brush inputs measured
+	double mean; //the average input-to-display latency, in milliseconds
+	double max; //the largest input-to-display latency, in milliseconds
+};
+
+//---------------------------------------------------------------//
+
+void track_input(SimCommand* command); //stamps the command with an id and the current time and remembers it until it becomes visible; only call from the input thread
+void preview_inputs(const FrameSnapshot& frame, FrameSnapshot* preview); //copies the frame and applies every remembered input the simulation hasn't applied yet; returns the id of the newest input applied in preview->lastCommand
+void record_present(Uint64 lastVisible); //marks every input up to the given id as visible as of now
+
+LatencyStats get_latency_stats(); //returns the telemetry since the last reset
+void reset_latency_stats(); //clears the telemetry
+
+void set_low_latency(bool enabled); //enables or disables low latency mode, which previews brush inputs on top of the latest frame before the simulation applies them
+bool get_low_latency(); //returns true if low latency mode is enabled, false otherwise
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+
+//a lock-free triple buffer for handing whole values from one writer thread to one reader thread
+//the writer never waits on the reader, and the reader always sees the most recently published value
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() : middle(1), back(0), front(2) {}
+
+	T& write_buffer() //returns the buffer the writer should fill before calling publish()
+	{
+		return buffers[back];
+	}
+
+	void publish() //makes the write buffer the latest value and hands the writer a free buffer
+	{
+		back = middle.exchange(back | DIRTY_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+	}
+
+	bool acquire() //grabs the latest published value if there is a new one; returns true if the read buffer changed
+	{
+		if (!(middle.load(std::memory_order_relaxed) & DIRTY_BIT))
+			return false;
+
+		front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+		return true;
+	}
+
+	const T& read_buffer() const //returns the value grabbed by the last successful acquire()
+	{
+		return buffers[front];
+	}
+
+private:
+	static const int INDEX_MASK = 3;
+	static const int DIRTY_BIT = 4;
+
+	T buffers[3];
+	std::atomic<int> middle; //index of the buffer between the writer and reader, plus DIRTY_BIT if it has not been read yet
+	int back; //only touched by the writer
+	int front; //only touched by the reader
+};
+
+//a lock-free bounded queue for one producer thread and one consumer thread
+template <typename T, int CAPACITY>
+class SpscQueue
+{
+public:
+	SpscQueue() : head(0), tail(0) {}
+
+	bool push(const T& item) //adds an item to the back of the queue; returns false if the queue is full
+	{
+		int t = tail.load(std::memory_order_relaxed);
+		int next = (t + 1) % CAPACITY;
+		if (next == head.load(std::memory_order_acquire))
+			return false;
+
+		items[t] = item;
+		tail.store(next, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(T& item) //removes the item at the front of the queue; returns false if the queue is empty
+	{
+		int h = head.load(std::memory_order_relaxed);
+		if (h == tail.load(std::memory_order_acquire))
+			return false;
+
+		item = items[h];
+		head.store((h + 1) % CAPACITY, std::memory_order_release);
+		return true;
+	}
+
+private:
+	T items[CAPACITY];
+	std::atomic<int> head; //only written by the consumer
+	std::atomic<int> tail; //only written by the producer
+};
\ No newline at end of file
@@ -1,11 +1,101 @@
 #include "simulation.h"
+#include "elements.h"
+#include "sim_thread.h"
+#include "pacer.h"
+#include "latency.h"
+#include "snapshot.h"
+#include "autosave.h"
+#include "recording.h"
+#include "image_import.h"
+#include "frame_export.h"
+#include "shared_frames.h"
+#include "frame_stream.h"
+#include "frame_stats.h"
 #include "SDL_image.h"
 #include <iostream>
 #include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <string>
 #include <thread>
 
+//bench constants:
+#define BENCH_SEED 1 //every engine is timed from the same seed, so they start from the same rolls
+
+struct Options //the options the program was launched with
+{
+	SimSettings sim;
+	bool fastForward; //whether or not to start in fast forward mode
+	bool pacingStats; //whether or not to print frame pacing telemetry every second
+	bool lowLatency; //whether or not to start in low latency mode
+	bool latencyStats; //whether or not to print input-to-display latency telemetry every second
+	const char* loadPath; //the world to load at startup, NULL to start empty
+	const char* importPath; //the image to import as the world at startup, NULL to not import one
+	double autosaveInterval; //the number of seconds between autosaves, 0 to disable autosaving
+	const char* autosavePath;
+	bool record; //whether or not to start recording input right away
+	const char* replayPath; //the recording to replay headless instead of opening a window, NULL to run normally
+	const char* exportPath; //the file frames are exported to, "-" for stdout, NULL to not export frames
+	ExportFormat exportFormat;
+	int exportInterval; //the number of ticks between exported frames
+	Uint64 headlessTicks; //the number of ticks to simulate without opening a window, 0 to run normally
+	const char* sharedFramesName; //the shared memory ring frames are published to, NULL to not publish them
+	const char* watchName; //the shared memory ring to watch instead of running a simulation, NULL to run normally
+	const char* servePath; //the unix socket to serve frames to a viewer on instead of opening a window, NULL to run normally
+	const char* connectPath; //the unix socket of the server to view instead of simulating locally, NULL to run normally
+	const char* statsPath; //the file per-tick stats are logged to, NULL to not log them
+	StatsFormat statsFormat;
+	bool granularBitboards; //whether or not to leave settled sand and gunpowder at rest using bitboards
+	SimEngine engine;
+	Uint64 benchTicks; //the number of ticks to time each engine over without opening a window, 0 to run normally
+	const char* elementsPath; //the element config file to load, NULL to only have the built-in elements
+};
+
+//global vars:
+static volatile sig_atomic_t serverRunning; //cleared by an interrupt to stop the server
+
+bool parse_options(int argc, char** argv, Options* options); //fills in the options from the command line; returns true on success, false on failure
+int run_replay(const char* path); //replays a recording without a window and reports how it went; returns the exit code
+int run_headless(const Options& options); //simulates a fixed number of ticks as fast as possible without a window, exporting frames if enabled; returns the exit code
+int run_bench(const Options& options); //times every engine over the same ticks from the same world and seed, without a window; returns the exit code
+int run_watch(const char* name); //reads frames from another process's shared memory ring and reports on them once a second until it stops publishing; returns the exit code
+bool start_stats(const Options& options); //starts logging stats if enabled; returns true on success, false on failure
+void stop_stats(const Options& options); //stops logging stats if enabled and reports how it went
+int run_server(const Options& options); //simulates without a window, streaming frames to a viewer and applying its input until interrupted; returns the exit code
+void stop_server(int); //the interrupt handler for the server
+
 int main(int argc, char** argv)
 {
+	//grab the command line options:
+	Options options;
+	if (!parse_options(argc, argv, &options))
+		return 0;
+
+	if (!init_elements(options.elementsPath))
+	{
+		std::cout << "failed to load elements from " << options.elementsPath << std::endl;
+		return 0;
+	}
+
+	set_granular_bitboards(options.granularBitboards);
+	set_sim_engine(options.engine);
+
+	//keep stdout clean for the frames if they're being exported there:
+	if (options.exportPath && strcmp(options.exportPath, "-") == 0)
+		std::cout.rdbuf(std::cerr.rdbuf());
+
+	if (options.watchName)
+		return run_watch(options.watchName);
+	if (options.replayPath)
+		return run_replay(options.replayPath);
+	if (options.benchTicks > 0)
+		return run_bench(options);
+	if (options.headlessTicks > 0)
+		return run_headless(options);
+	if (options.servePath)
+		return run_server(options);
+
 	//declare window and start running:
 	SDL_Window* window;
 	running = true;
@@ -25,40 +115,641 @@ int main(int argc, char** argv)
 		return 0;
 
 	//initialize the simulation:
-	if (!init_simulation(window))
+	using clock = std::chrono::steady_clock;
+
+	clock::time_point loadStart = clock::now();
+	if (!init_simulation(window, options.loadPath))
+	{
+		if (options.loadPath)
+			std::cout << "failed to load world from " << options.loadPath << std::endl;
 		return 0;
+	}
 
-	//declare timestepping variables:
-	using clock = std::chrono::steady_clock;
+	if (options.loadPath)
+		std::cout << "loaded world from " << options.loadPath << " in " << std::chrono::duration<double, std::milli>(clock::now() - loadStart).count() << " ms" << std::endl;
 
-	const double frameDelay = 1000 / 60; //fps
-	clock::time_point start = clock::now();
-	clock::time_point last = clock::now();
+	if (options.connectPath && !connect_stream(options.connectPath))
+	{
+		std::cout << "failed to connect to " << options.connectPath << std::endl;
+		return 0;
+	}
+
+	if (options.importPath)
+	{
+		clock::time_point importStart = clock::now();
+		if (!import_world(options.importPath, get_grid(), WIDTH, HEIGHT))
+		{
+			std::cout << "failed to import world from " << options.importPath << std::endl;
+			return 0;
+		}
+
+		reindex_grid();
+		std::cout << "imported world from " << options.importPath << " in " << std::chrono::duration<double, std::milli>(clock::now() - importStart).count() << " ms" << std::endl;
+	}
+
+	if (options.autosaveInterval > 0.0 && !start_autosave(options.autosavePath, options.autosaveInterval))
+		return 0;
+
+	if (options.exportPath && !start_export(options.exportPath, options.exportFormat, options.exportInterval, options.sim.displayHz, false))
+	{
+		std::cout << "failed to start exporting frames to " << options.exportPath << std::endl;
+		return 0;
+	}
+
+	if (options.sharedFramesName && !start_shared_frames(options.sharedFramesName))
+	{
+		std::cout << "failed to share frames as " << options.sharedFramesName << std::endl;
+		return 0;
+	}
+
+	if (!options.connectPath && !start_stats(options))
+		return 0;
+
+	//start simulating on a separate thread so rendering and simulating don't hold each other up, unless viewing a server's simulation:
+	if (!options.connectPath && !start_sim_thread(options.sim))
+		return 0;
+
+	//frames from a server arrive as deltas, start from an empty world and apply them as they come in:
+	FrameSnapshot* remoteFrame = NULL;
+	if (options.connectPath)
+	{
+		remoteFrame = new FrameSnapshot();
+		memset(remoteFrame->types, (int)ParticleType::empty, sizeof(remoteFrame->types));
+	}
+
+	set_fast_forward(options.fastForward);
+	set_low_latency(options.lowLatency);
+
+	if (options.record)
+	{
+		SimCommand command;
+		command.type = CommandType::toggleRecording;
+		command.id = 0;
+		if (options.connectPath)
+			send_stream_command(command);
+		else
+			push_command(command);
+	}
+
+	//declare timestepping variables:
+	FramePacer pacer;
+	init_pacer(&pacer, options.sim.displayHz, options.sim.spinPolicy);
+	clock::time_point lastSecond = clock::now();
+	Uint64 frameCount = 0;
 
 	//timestep until running = false:
 	while (running)
 	{
-		start = clock::now();
-		std::chrono::duration<double, std::milli> workTime = start - last;
-		//std::cout << workTime.count() << std::endl;
+		wait_for_next_frame(&pacer); //wait to keep fps capped
+		handle_input();
 
-		if (workTime.count() < frameDelay)
+		if (remoteFrame && !update_stream_client(remoteFrame))
 		{
-			std::chrono::duration<double, std::milli> deltaMs(frameDelay - workTime.count());
-			auto deltaMsDuration = std::chrono::duration_cast<std::chrono::milliseconds>(deltaMs);
-			std::this_thread::sleep_for(std::chrono::milliseconds(deltaMsDuration.count())); //sleep to keep fps capped
+			std::cout << "lost connection to " << options.connectPath << std::endl;
+			break;
 		}
 
-		last = clock::now();
+		//while fast forwarding only render every few frames, leaving more time to simulate:
+		frameCount++;
+		bool fastForward = get_fast_forward();
+		if (!fastForward || frameCount % FAST_FORWARD_RENDER_INTERVAL == 0)
+			render(remoteFrame ? *remoteFrame : get_latest_frame());
 
-		handle_input();
-		run_simulation();
-		render();
+		//report the achieved tick rate in the title once a second while fast forwarding, and optionally the pacing telemetry:
+		clock::time_point now = clock::now();
+		if (now - lastSecond >= std::chrono::seconds(1))
+		{
+			lastSecond = now;
+
+			std::string title = "ElementSim";
+			if (fastForward)
+				title += " - fast forward: " + std::to_string((int)get_ticks_per_second()) + " ticks/s";
+			SDL_SetWindowTitle(window, title.c_str());
+
+			if (options.pacingStats)
+			{
+				PacingStats stats = get_pacing_stats(&pacer);
+				std::cout << "frame pacing: " << stats.frames << " frames, " << stats.missed << " missed, lateness mean " << stats.meanLateness <<
+					" ms, max " << stats.maxLateness << " ms, jitter " << stats.jitter << " ms" << std::endl;
+			}
+			reset_pacing_stats(&pacer);
+
+			if (options.latencyStats)
+			{
+				LatencyStats stats = get_latency_stats();
+				std::cout << "input latency: " << stats.samples << " inputs, mean " << stats.mean << " ms, max " << stats.max << " ms" << std::endl;
+			}
+			reset_latency_stats();
+		}
 	}
 
 	//clean up before exiting:
+	stop_sim_thread();
+	stop_autosave();
+	if (options.exportPath)
+	{
+		ExportStats stats = stop_export();
+		std::cout << "exported " << stats.written << " frames, dropped " << stats.dropped << std::endl;
+	}
+	stop_shared_frames();
+	stop_stats(options);
+	disconnect_stream();
+	delete remoteFrame;
 	close_simulation();
 	SDL_DestroyWindow(window);
 
 	return 0;
+}
+
+bool parse_options(int argc, char** argv, Options* options)
+{
+	options->sim = default_sim_settings();
+	options->fastForward = false;
+	options->pacingStats = false;
+	options->lowLatency = false;
+	options->latencyStats = false;
+	options->loadPath = NULL;
+	options->importPath = NULL;
+	options->autosaveInterval = 0.0;
+	options->autosavePath = DEFAULT_AUTOSAVE_PATH;
+	options->record = false;
+	options->replayPath = NULL;
+	options->exportPath = NULL;
+	options->exportFormat = ExportFormat::y4m;
+	options->exportInterval = DEFAULT_EXPORT_INTERVAL;
+	options->headlessTicks = 0;
+	options->sharedFramesName = NULL;
+	options->watchName = NULL;
+	options->servePath = NULL;
+	options->connectPath = NULL;
+	options->statsPath = NULL;
+	options->statsFormat = StatsFormat::csv;
+	options->granularBitboards = false;
+	options->engine = SimEngine::sweep;
+	options->benchTicks = 0;
+	options->elementsPath = NULL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+
+		if (strcmp(argv[i], "--sim-hz") == 0 && hasValue)
+			options->sim.simHz = atof(argv[++i]);
+		else if (strcmp(argv[i], "--fps") == 0 && hasValue)
+			options->sim.displayHz = atof(argv[++i]);
+		else if (strcmp(argv[i], "--max-substeps") == 0 && hasValue)
+			options->sim.maxSubsteps = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--fast-forward") == 0)
+			options->fastForward = true;
+		else if (strcmp(argv[i], "--spin-policy") == 0 && hasValue)
+		{
+			if (!parse_spin_policy(argv[++i], &options->sim.spinPolicy))
+			{
+				std::cout << "--spin-policy must be sleep, yield or spin" << std::endl;
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--pacing-stats") == 0)
+			options->pacingStats = true;
+		else if (strcmp(argv[i], "--low-latency") == 0)
+			options->lowLatency = true;
+		else if (strcmp(argv[i], "--latency-stats") == 0)
+			options->latencyStats = true;
+		else if (strcmp(argv[i], "--world") == 0 && hasValue)
+			options->sim.worldPath = argv[++i];
+		else if (strcmp(argv[i], "--load") == 0 && hasValue)
+			options->loadPath = argv[++i];
+		else if (strcmp(argv[i], "--import") == 0 && hasValue)
+			options->importPath = argv[++i];
+		else if (strcmp(argv[i], "--raw-snapshots") == 0)
+			options->sim.rawSnapshots = true;
+		else if (strcmp(argv[i], "--autosave") == 0 && hasValue)
+			options->autosaveInterval = atof(argv[++i]);
+		else if (strcmp(argv[i], "--autosave-path") == 0 && hasValue)
+			options->autosavePath = argv[++i];
+		else if (strcmp(argv[i], "--record") == 0 && hasValue)
+		{
+			options->record = true;
+			options->sim.recordingPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--recording-path") == 0 && hasValue)
+			options->sim.recordingPath = argv[++i];
+		else if (strcmp(argv[i], "--replay") == 0 && hasValue)
+			options->replayPath = argv[++i];
+		else if (strcmp(argv[i], "--export") == 0 && hasValue)
+			options->exportPath = argv[++i];
+		else if (strcmp(argv[i], "--export-format") == 0 && hasValue)
+		{
+			if (!parse_export_format(argv[++i], &options->exportFormat))
+			{
+				std::cout << "--export-format must be rgb, ppm or y4m" << std::endl;
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--export-interval") == 0 && hasValue)
+			options->exportInterval = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--headless") == 0 && hasValue)
+			options->headlessTicks = strtoull(argv[++i], NULL, 10);
+		else if (strcmp(argv[i], "--share-frames") == 0 && hasValue)
+			options->sharedFramesName = argv[++i];
+		else if (strcmp(argv[i], "--watch-frames") == 0 && hasValue)
+			options->watchName = argv[++i];
+		else if (strcmp(argv[i], "--serve") == 0 && hasValue)
+			options->servePath = argv[++i];
+		else if (strcmp(argv[i], "--connect") == 0 && hasValue)
+			options->connectPath = argv[++i];
+		else if (strcmp(argv[i], "--stats") == 0 && hasValue)
+			options->statsPath = argv[++i];
+		else if (strcmp(argv[i], "--stats-format") == 0 && hasValue)
+		{
+			if (!parse_stats_format(argv[++i], &options->statsFormat))
+			{
+				std::cout << "--stats-format must be csv or binary" << std::endl;
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--granular-bitboards") == 0)
+			options->granularBitboards = true;
+		else if (strcmp(argv[i], "--engine") == 0 && hasValue)
+		{
+			if (!parse_sim_engine(argv[++i], &options->engine))
+			{
+				std::cout << "--engine must be sweep or margolus" << std::endl;
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--bench") == 0 && hasValue)
+			options->benchTicks = strtoull(argv[++i], NULL, 10);
+		else if (strcmp(argv[i], "--elements") == 0 && hasValue)
+			options->elementsPath = argv[++i];
+		else if (strcmp(argv[i], "--rewind-memory") == 0 && hasValue)
+			options->sim.rewindMemory = (size_t)(atof(argv[++i]) * 1024 * 1024);
+		else if (strcmp(argv[i], "--rewind-step") == 0 && hasValue)
+			options->sim.rewindStep = atof(argv[++i]);
+		else
+		{
+			std::cout << "unknown option: " << argv[i] << std::endl;
+			return false;
+		}
+	}
+
+	if (options->sim.simHz <= 0.0 || options->sim.displayHz <= 0.0 || options->sim.maxSubsteps < 1)
+	{
+		std::cout << "--sim-hz and --fps must be positive and --max-substeps must be at least 1" << std::endl;
+		return false;
+	}
+
+	if (options->exportInterval < 1)
+	{
+		std::cout << "--export-interval must be at least 1" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+int run_replay(const char* path)
+{
+	if (!init_simulation(NULL, NULL))
+		return 1;
+
+	ReplayStats stats;
+	bool loaded = replay_recording(path, &stats);
+	close_simulation();
+
+	if (!loaded)
+	{
+		std::cout << "failed to replay " << path << std::endl;
+		return 1;
+	}
+
+	std::cout << "replayed " << stats.ticks << " ticks and " << stats.brushes << " brushes in " << stats.seconds * 1000.0 << " ms (" <<
+		(stats.seconds > 0.0 ? stats.ticks / stats.seconds : 0.0) << " ticks/s) with the " << (stats.engine == SimEngine::margolus ? "margolus" : "sweep") << " engine" <<
+		(stats.granularBitboards ? " and granular bitboards" : "") << std::endl;
+
+	if (!stats.finished)
+	{
+		std::cout << "recording was cut short, replayed up to its last event" << std::endl;
+		return 1;
+	}
+
+	std::cout << (stats.matched ? "final world matches the recording" : "final world does not match the recording") << std::endl;
+	return stats.matched ? 0 : 1;
+}
+
+int run_headless(const Options& options)
+{
+	using clock = std::chrono::steady_clock;
+
+	if (!init_simulation(NULL, options.loadPath))
+	{
+		if (options.loadPath)
+			std::cout << "failed to load world from " << options.loadPath << std::endl;
+		return 1;
+	}
+
+	if (options.importPath && !import_world(options.importPath, get_grid(), WIDTH, HEIGHT))
+	{
+		std::cout << "failed to import world from " << options.importPath << std::endl;
+		close_simulation();
+		return 1;
+	}
+	reindex_grid();
+
+	//headless runs have no real-time deadline, so wait for the writer rather than leave gaps in the export:
+	if (options.exportPath && !start_export(options.exportPath, options.exportFormat, options.exportInterval, options.sim.displayHz, true))
+	{
+		std::cout << "failed to start exporting frames to " << options.exportPath << std::endl;
+		close_simulation();
+		return 1;
+	}
+
+	if (options.sharedFramesName && !start_shared_frames(options.sharedFramesName))
+	{
+		std::cout << "failed to share frames as " << options.sharedFramesName << std::endl;
+		stop_export();
+		close_simulation();
+		return 1;
+	}
+
+	if (!start_stats(options))
+	{
+		stop_export();
+		stop_shared_frames();
+		close_simulation();
+		return 1;
+	}
+
+	//every tick is a completed frame here, only capture it if someone can read it:
+	FrameSnapshot* frame = options.sharedFramesName ? new FrameSnapshot() : NULL;
+
+	clock::time_point start = clock::now();
+	for (Uint64 tick = 1; tick <= options.headlessTicks; tick++)
+	{
+		double phaseTimes[PHASE_COUNT] = {};
+		clock::time_point phaseStart = clock::now();
+
+		run_simulation();
+
+		clock::time_point simulated = clock::now();
+		phaseTimes[(int)TickPhase::simulate] = std::chrono::duration<double, std::milli>(simulated - phaseStart).count();
+
+		update_export(tick, get_grid());
+
+		if (frame)
+		{
+			capture_frame(frame);
+			frame->tick = tick;
+			frame->lastCommand = 0;
+			publish_shared_frame(*frame);
+		}
+
+		phaseTimes[(int)TickPhase::output] = std::chrono::duration<double, std::milli>(clock::now() - simulated).count();
+		update_stats_log(tick, phaseTimes);
+	}
+	double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+	std::cout << "simulated " << options.headlessTicks << " ticks in " << seconds * 1000.0 << " ms (" << options.headlessTicks / seconds << " ticks/s)" << std::endl;
+	if (options.exportPath)
+	{
+		ExportStats stats = stop_export();
+		std::cout << "exported " << stats.written << " frames, dropped " << stats.dropped << std::endl;
+	}
+
+	delete frame;
+	stop_shared_frames();
+	stop_stats(options);
+	close_simulation();
+	return 0;
+}
+
+int run_bench(const Options& options)
+{
+	using clock = std::chrono::steady_clock;
+
+	const SimEngine engines[] = { SimEngine::sweep, SimEngine::margolus };
+	const char* names[] = { "sweep", "margolus" };
+
+	for (int i = 0; i < 2; i++)
+	{
+		if (!init_simulation(NULL, options.loadPath))
+		{
+			if (options.loadPath)
+				std::cout << "failed to load world from " << options.loadPath << std::endl;
+			return 1;
+		}
+
+		if (options.importPath && !import_world(options.importPath, get_grid(), WIDTH, HEIGHT))
+		{
+			std::cout << "failed to import world from " << options.importPath << std::endl;
+			close_simulation();
+			return 1;
+		}
+		reindex_grid();
+		seed_simulation(BENCH_SEED);
+		set_sim_engine(engines[i]);
+
+		Uint64 swaps = 0;
+		clock::time_point start = clock::now();
+		for (Uint64 tick = 0; tick < options.benchTicks; tick++)
+		{
+			tickCounters = TickCounters();
+			run_simulation();
+			swaps += tickCounters.swaps;
+		}
+		double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+		std::cout << names[i] << ": " << options.benchTicks << " ticks in " << seconds * 1000.0 << " ms (" << options.benchTicks / seconds << " ticks/s, " <<
+			(double)swaps / options.benchTicks << " moves/tick)" << std::endl;
+
+		close_simulation();
+	}
+
+	set_sim_engine(options.engine);
+	return 0;
+}
+
+int run_watch(const char* name)
+{
+	using clock = std::chrono::steady_clock;
+
+	SharedFramesView view;
+	if (!open_shared_frames(name, &view))
+	{
+		std::cout << "failed to open shared frames " << name << std::endl;
+		return 1;
+	}
+
+	//report on the newest frame once a second, reading it in place:
+	Uint64 lastFrame = 0;
+	clock::time_point lastNewFrame = clock::now();
+	while (clock::now() - lastNewFrame < std::chrono::seconds(5))
+	{
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+
+		const Uint8* types;
+		Uint64 tick;
+		Uint64 frame = get_shared_frame(view, &types, &tick);
+		if (frame == 0 || frame == lastFrame)
+			continue;
+
+		int particles = 0;
+		for (int i = 0; i < WIDTH * HEIGHT; i++)
+			particles += types[i] != (Uint8)ParticleType::empty;
+
+		if (!shared_frame_intact(view, frame))
+			continue;
+
+		std::cout << "frame " << frame << " (tick " << tick << "): " << particles << " particles, " << frame - lastFrame << " frames since the last report" << std::endl;
+		lastFrame = frame;
+		lastNewFrame = clock::now();
+	}
+
+	std::cout << "no new frames for 5 seconds, stopping" << std::endl;
+	close_shared_frames(&view);
+	return 0;
+}
+
+bool start_stats(const Options& options)
+{
+	if (options.statsPath && !start_stats_log(options.statsPath, options.statsFormat))
+	{
+		std::cout << "failed to start logging stats to " << options.statsPath << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+void stop_stats(const Options& options)
+{
+	if (!options.statsPath)
+		return;
+
+	StatsLogStats stats = stop_stats_log();
+	std::cout << "logged stats for " << stats.written << " ticks, dropped " << stats.dropped << std::endl;
+}
+
+int run_server(const Options& options)
+{
+	using clock = std::chrono::steady_clock;
+
+	if (!init_simulation(NULL, options.loadPath))
+	{
+		if (options.loadPath)
+			std::cout << "failed to load world from " << options.loadPath << std::endl;
+		return 1;
+	}
+
+	if (options.importPath && !import_world(options.importPath, get_grid(), WIDTH, HEIGHT))
+	{
+		std::cout << "failed to import world from " << options.importPath << std::endl;
+		close_simulation();
+		return 1;
+	}
+	reindex_grid();
+
+	if (!start_stream_server(options.servePath))
+	{
+		std::cout << "failed to serve frames on " << options.servePath << std::endl;
+		close_simulation();
+		return 1;
+	}
+
+	//a server is the long running world autosaves protect, and it keeps the real-time pace of the windowed path, dropping frames the export can't keep up with:
+	if (options.autosaveInterval > 0.0 && !start_autosave(options.autosavePath, options.autosaveInterval))
+	{
+		stop_stream_server();
+		close_simulation();
+		return 1;
+	}
+
+	if (options.exportPath && !start_export(options.exportPath, options.exportFormat, options.exportInterval, options.sim.displayHz, false))
+	{
+		std::cout << "failed to start exporting frames to " << options.exportPath << std::endl;
+		stop_autosave();
+		stop_stream_server();
+		close_simulation();
+		return 1;
+	}
+
+	if (options.sharedFramesName && !start_shared_frames(options.sharedFramesName))
+	{
+		std::cout << "failed to share frames as " << options.sharedFramesName << std::endl;
+		stop_export();
+		stop_autosave();
+		stop_stream_server();
+		close_simulation();
+		return 1;
+	}
+
+	if (!start_stats(options))
+	{
+		stop_shared_frames();
+		stop_export();
+		stop_autosave();
+		stop_stream_server();
+		close_simulation();
+		return 1;
+	}
+
+	if (!start_sim_thread(options.sim))
+	{
+		stop_stats(options);
+		stop_shared_frames();
+		stop_export();
+		stop_autosave();
+		stop_stream_server();
+		close_simulation();
+		return 1;
+	}
+
+	set_fast_forward(options.fastForward);
+	std::cout << "serving frames on " << options.servePath << std::endl;
+
+	//stream each completed frame to the viewer at the display rate, reporting the bandwidth once a second:
+	serverRunning = 1;
+	signal(SIGINT, stop_server);
+	signal(SIGTERM, stop_server);
+
+	FramePacer pacer;
+	init_pacer(&pacer, options.sim.displayHz, options.sim.spinPolicy);
+	clock::time_point lastSecond = clock::now();
+	Uint64 lastBytes = 0;
+
+	while (serverRunning)
+	{
+		wait_for_next_frame(&pacer);
+		update_stream_server(get_latest_frame());
+
+		clock::time_point now = clock::now();
+		if (now - lastSecond >= std::chrono::seconds(1))
+		{
+			Uint64 bytes = get_stream_bytes_sent();
+			if (bytes != lastBytes)
+				std::cout << "streamed " << (bytes - lastBytes) / 1024.0 / std::chrono::duration<double>(now - lastSecond).count() << " KB/s" << std::endl;
+
+			lastSecond = now;
+			lastBytes = bytes;
+		}
+	}
+
+	std::cout << "stopping server" << std::endl;
+	stop_sim_thread();
+	stop_stream_server();
+	stop_autosave();
+	if (options.exportPath)
+	{
+		ExportStats stats = stop_export();
+		std::cout << "exported " << stats.written << " frames, dropped " << stats.dropped << std::endl;
+	}
+	stop_shared_frames();
+	stop_stats(options);
+	close_simulation();
+	return 0;
+}
+
+void stop_server(int)
+{
+	serverRunning = 0;
 }
\ No newline at end of file
@@ -0,0 +1,285 @@
+#include "margolus.h"
+#include "simulation.h"
+#include "elements.h"
+#include "reactions.h"
+#include "frame_stats.h"
+#include <algorithm>
+#include <cstdlib>
+
+//the cells of a block are numbered 0 = top left, 1 = top right, 2 = bottom left, 3 = bottom right
+#define IDENTITY_PERMUTATION 0xE4 //every cell staying where it is, packed two bits per destination
+
+enum class CellClass //what the block rules tell apart, as far as moving goes
+{
+	empty,
+	liquid,
+	granular,
+	gas,
+	fixed //wood, stone and fire, which never move, as well as the cells past the edge of the grid
+};
+
+//global vars:
+static Uint8 permutations[MARGOLUS_KEYS][MARGOLUS_VARIANTS]; //the source of every destination cell, indexed by block key then variant
+
+//---------------------------------------------------------------//
+
+Uint8 find_permutation(const CellClass* block, bool topple); //applies the block rules to the classes, returning the packed permutation for the unmirrored block
+CellClass get_class(int x, int y); //returns the class of the cell at the given position, fixed if out of bounds
+int get_weight(CellClass c); //returns how readily a class sinks below another, or -1 if it never moves
+Uint32 hash_block(Uint32 seed, int block); //returns a well mixed nonzero starting point for a block's random numbers
+Uint32 next_roll(Uint32* state); //steps a block's random numbers, returning the next one
+void update_block(int bx, int by, Uint32 rolls); //rearranges, reacts and ages the block with its top left corner at the given position
+
+void init_margolus()
+{
+	for (int key = 0; key < MARGOLUS_KEYS; key++)
+	{
+		CellClass block[4];
+		CellClass mirrored[4];
+		for (int i = 0, k = key; i < 4; i++, k /= MARGOLUS_CLASSES)
+			block[i] = (CellClass)(k % MARGOLUS_CLASSES);
+		for (int i = 0; i < 4; i++)
+			mirrored[i] = block[i ^ 1];
+
+		for (int variant = 0; variant < MARGOLUS_VARIANTS; variant++)
+		{
+			bool mirror = (variant & 1) != 0;
+			bool topple = (variant & 2) != 0;
+
+			if (!mirror)
+			{
+				permutations[key][variant] = find_permutation(block, topple);
+				continue;
+			}
+
+			//rule the mirrored block, then mirror the sources and destinations back:
+			Uint8 perm = find_permutation(mirrored, topple);
+			Uint8 unmirrored = 0;
+			for (int dest = 0; dest < 4; dest++)
+			{
+				int src = (perm >> (dest * 2)) & 3;
+				unmirrored |= (src ^ 1) << ((dest ^ 1) * 2);
+			}
+			permutations[key][variant] = unmirrored;
+		}
+	}
+}
+
+void run_margolus(bool offset)
+{
+	Uint32 seed = (Uint32)rand();
+	int start = offset ? -1 : 0;
+
+	int block = 0;
+	for (int by = start; by < HEIGHT; by += 2)
+		for (int bx = start; bx < WIDTH; bx += 2)
+			update_block(bx, by, hash_block(seed, block++));
+}
+
+//---------------------------------------------------------------//
+
+Uint8 find_permutation(const CellClass* block, bool topple)
+{
+	CellClass cells[4];
+	int sources[4] = { 0, 1, 2, 3 };
+	bool moved[4] = { false, false, false, false };
+	for (int i = 0; i < 4; i++)
+		cells[i] = block[i];
+
+	auto move = [&](int a, int b)
+	{
+		std::swap(cells[a], cells[b]);
+		std::swap(sources[a], sources[b]);
+		moved[a] = moved[b] = true;
+	};
+
+	//fall, sink and rise within each column:
+	for (int col = 0; col < 2; col++)
+	{
+		int top = col;
+		int bottom = col + 2;
+		if (get_weight(cells[top]) > get_weight(cells[bottom]) && get_weight(cells[bottom]) >= 0)
+			move(top, bottom);
+	}
+
+	//topple diagonally when held up, left column first:
+	for (int col = 0; col < 2; col++)
+	{
+		int top = col;
+		int bottom = col + 2;
+		int otherTop = col ^ 1;
+		int otherBottom = otherTop + 2;
+
+		bool falls = cells[top] == CellClass::liquid || (cells[top] == CellClass::granular && topple);
+		if (falls && !moved[top] && !moved[otherBottom] && cells[bottom] != CellClass::empty && cells[otherBottom] == CellClass::empty)
+			move(top, otherBottom);
+
+		if (cells[bottom] == CellClass::gas && !moved[bottom] && !moved[otherTop] && cells[top] != CellClass::empty && cells[otherTop] == CellClass::empty)
+			move(bottom, otherTop);
+	}
+
+	//spread sideways, liquids along the bottom or when held up and gases along the top or when held down:
+	for (int row = 0; row < 2; row++)
+	{
+		int left = row * 2;
+		int right = left + 1;
+		for (int side = 0; side < 2; side++)
+		{
+			int from = side == 0 ? left : right;
+			int to = side == 0 ? right : left;
+			if (moved[from] || moved[to] || cells[to] != CellClass::empty)
+				continue;
+
+			bool spreads = false;
+			if (cells[from] == CellClass::liquid)
+				spreads = row == 1 || cells[from + 2] != CellClass::empty;
+			else if (cells[from] == CellClass::gas)
+				spreads = row == 0 || cells[from - 2] != CellClass::empty;
+
+			if (spreads)
+				move(from, to);
+		}
+	}
+
+	Uint8 perm = 0;
+	for (int dest = 0; dest < 4; dest++)
+		perm |= sources[dest] << (dest * 2);
+
+	return perm;
+}
+
+CellClass get_class(int x, int y)
+{
+	if (!in_bounds(x, y))
+		return CellClass::fixed;
+
+	Particle* p = get_p(x, y);
+	switch (p->flag)
+	{
+	case ParticleFlag::liquid:
+		return CellClass::liquid;
+	case ParticleFlag::gas:
+		return CellClass::gas;
+	case ParticleFlag::empty:
+		return CellClass::empty;
+	default:
+		return (elementDescriptors[(int)p->type].classes & ELEMENT_GRANULAR) ? CellClass::granular : CellClass::fixed;
+	}
+}
+
+int get_weight(CellClass c)
+{
+	switch (c)
+	{
+	case CellClass::gas:
+		return 0;
+	case CellClass::empty:
+		return 1;
+	case CellClass::liquid:
+		return 2;
+	case CellClass::granular:
+		return 3;
+	default:
+		return -1;
+	}
+}
+
+Uint32 hash_block(Uint32 seed, int block)
+{
+	Uint32 h = seed ^ ((Uint32)block * 0x9E3779B9u);
+	h ^= h >> 16;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35u;
+	h ^= h >> 16;
+
+	return h != 0 ? h : 1;
+}
+
+Uint32 next_roll(Uint32* state)
+{
+	Uint32 x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+
+	return x;
+}
+
+void update_block(int bx, int by, Uint32 rolls)
+{
+	const int xs[4] = { bx, bx + 1, bx, bx + 1 };
+	const int ys[4] = { by, by, by + 1, by + 1 };
+
+	CellClass classes[4];
+	bool active = false; //whether or not anything in the block reacts or ages
+	int key = 0;
+	for (int i = 3; i >= 0; i--)
+	{
+		classes[i] = get_class(xs[i], ys[i]);
+		key = key * MARGOLUS_CLASSES + (int)classes[i];
+
+		if (classes[i] == CellClass::fixed && !in_bounds(xs[i], ys[i]))
+			continue;
+
+		const ElementDescriptor& element = elementDescriptors[(int)get_p(xs[i], ys[i])->type];
+		if (!element.isStatic)
+			tickCounters.updated++;
+		if (element.classes & (ELEMENT_REACTIVE | ELEMENT_AGING))
+			active = true;
+	}
+
+	//rearrange with a single table lookup:
+	Uint32 roll = next_roll(&rolls);
+	int variant = (roll & 1) | ((roll >> 1) % MARGOLUS_TOPPLE_CHANCE != 0 ? 2 : 0);
+	Uint8 perm = permutations[key][variant];
+	if (perm != IDENTITY_PERMUTATION)
+	{
+		//only cells in bounds ever move, being anything but fixed:
+		Particle cells[4];
+		for (int i = 0; i < 4; i++)
+			if (classes[i] != CellClass::fixed)
+				cells[i] = *get_p(xs[i], ys[i]);
+
+		for (int dest = 0; dest < 4; dest++)
+		{
+			int src = (perm >> (dest * 2)) & 3;
+			if (src != dest)
+				set_p(xs[dest], ys[dest], cells[src]);
+		}
+		tickCounters.swaps++;
+	}
+
+	//let denser liquids sink through lighter ones:
+	for (int col = 0; col < 2; col++)
+	{
+		int top = col;
+		int bottom = col + 2;
+		if (classes[top] == CellClass::fixed || classes[bottom] == CellClass::fixed)
+			continue;
+
+		Particle* topP = get_p(xs[top], ys[top]);
+		Particle* bottomP = get_p(xs[bottom], ys[bottom]);
+		if (topP->flag == ParticleFlag::liquid && bottomP->flag == ParticleFlag::liquid && elements.density[(int)topP->type] > elements.density[(int)bottomP->type])
+			swap(xs[top], ys[top], xs[bottom], ys[bottom]);
+	}
+
+	if (!active)
+		return;
+
+	//react along the four edges inside the block:
+	const int edges[4][2] = { { 0, 1 }, { 2, 3 }, { 0, 2 }, { 1, 3 } };
+	for (int i = 0; i < 4; i++)
+	{
+		int a = edges[i][0];
+		int b = edges[i][1];
+		if (in_bounds(xs[a], ys[a]) && in_bounds(xs[b], ys[b]))
+			react_pair(xs[a], ys[a], xs[b], ys[b], next_roll(&rolls));
+	}
+
+	//count down lifetimes, fire gives off smoke through its reactions along the columns:
+	for (int i = 0; i < 4; i++)
+		if (in_bounds(xs[i], ys[i]))
+			age_particle(xs[i], ys[i]);
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+#include "particles.h"
+
+//margolus constants:
+#define MARGOLUS_CLASSES 5 //empty, liquid, granular, gas and fixed
+#define MARGOLUS_KEYS (MARGOLUS_CLASSES * MARGOLUS_CLASSES * MARGOLUS_CLASSES * MARGOLUS_CLASSES) //every combination of classes in a 2x2 block
+#define MARGOLUS_VARIANTS 4 //mirrored or not, times sand and gunpowder toppling or not
+#define MARGOLUS_TOPPLE_CHANCE 4 //one in this many blocks keeps its sand and gunpowder from toppling diagonally, so piles hold a slope
+
+//---------------------------------------------------------------//
+
+void init_margolus(); //builds the table of block rearrangements; call once before running the engine
+void run_margolus(bool offset); //runs one tick of the 2x2 block engine over the whole grid, with blocks starting at odd positions if offset = true; draws a single number from the rng for the tick
\ No newline at end of file
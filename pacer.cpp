@@ -0,0 +1,99 @@
+#include "pacer.h"
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+void init_pacer(FramePacer* pacer, double hz, SpinPolicy policy)
+{
+	using clock = std::chrono::steady_clock;
+
+	pacer->period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / hz));
+	pacer->policy = policy;
+	restart_pacer(pacer);
+	reset_pacing_stats(pacer);
+}
+
+void wait_for_next_frame(FramePacer* pacer)
+{
+	using clock = std::chrono::steady_clock;
+
+	clock::time_point target = pacer->nextFrame;
+
+	if (pacer->policy == SpinPolicy::sleep)
+		std::this_thread::sleep_until(target);
+	else
+	{
+		//sleep coarsely, waking up early enough to absorb the OS's sleep granularity:
+		clock::time_point wake = target - std::chrono::microseconds(PACER_SPIN_WINDOW_US);
+		if (clock::now() < wake)
+			std::this_thread::sleep_until(wake);
+
+		//spin for the rest of the way:
+		while (clock::now() < target)
+			if (pacer->policy == SpinPolicy::yield)
+				std::this_thread::yield();
+	}
+
+	//record how late the frame started:
+	clock::time_point now = clock::now();
+	double lateness = std::chrono::duration<double, std::milli>(now - target).count();
+	pacer->frames++;
+	pacer->latenessSum += lateness;
+	pacer->latenessSqSum += lateness * lateness;
+	if (lateness > pacer->maxLateness)
+		pacer->maxLateness = lateness;
+
+	//schedule the next frame, skipping ahead instead of trying to catch up if we missed a whole period:
+	pacer->nextFrame = target + pacer->period;
+	if (pacer->nextFrame <= now)
+	{
+		pacer->missed++;
+		pacer->nextFrame = now + pacer->period;
+	}
+}
+
+void restart_pacer(FramePacer* pacer)
+{
+	pacer->nextFrame = std::chrono::steady_clock::now();
+}
+
+PacingStats get_pacing_stats(const FramePacer* pacer)
+{
+	PacingStats stats;
+	stats.frames = pacer->frames;
+	stats.missed = pacer->missed;
+	stats.meanLateness = 0.0;
+	stats.maxLateness = pacer->maxLateness;
+	stats.jitter = 0.0;
+
+	if (pacer->frames > 0)
+	{
+		stats.meanLateness = pacer->latenessSum / pacer->frames;
+		stats.jitter = sqrt(fmax(pacer->latenessSqSum / pacer->frames - stats.meanLateness * stats.meanLateness, 0.0));
+	}
+
+	return stats;
+}
+
+void reset_pacing_stats(FramePacer* pacer)
+{
+	pacer->frames = 0;
+	pacer->missed = 0;
+	pacer->latenessSum = 0.0;
+	pacer->latenessSqSum = 0.0;
+	pacer->maxLateness = 0.0;
+}
+
+bool parse_spin_policy(const char* name, SpinPolicy* policy)
+{
+	if (strcmp(name, "sleep") == 0)
+		*policy = SpinPolicy::sleep;
+	else if (strcmp(name, "yield") == 0)
+		*policy = SpinPolicy::yield;
+	else if (strcmp(name, "spin") == 0)
+		*policy = SpinPolicy::spin;
+	else
+		return false;
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+#include <chrono>
+
+//pacer constants:
+#define PACER_SPIN_WINDOW_US 2000 //how long before a frame's target start time the pacer stops sleeping and starts spinning, in microseconds
+
+enum class SpinPolicy //represents how the pacer waits out the final stretch before a frame
+{
+	sleep, //sleep the whole way, saving power at the cost of OS timer granularity
+	yield, //spin, yielding the core to other threads between checks
+	spin //spin without yielding for the tightest timing
+};
+
+struct PacingStats //telemetry comparing target and actual frame start times
+{
+	int frames; //the number of frames measured
+	int missed; //the number of frames that started a whole period or more late
+	double meanLateness; //the average time between a frame's target and actual start, in milliseconds
+	double maxLateness; //the largest time between a frame's target and actual start, in milliseconds
+	double jitter; //the standard deviation of the lateness, in milliseconds
+};
+
+struct FramePacer //keeps frames starting at a fixed rate
+{
+	std::chrono::steady_clock::duration period; //the time between frame starts
+	std::chrono::steady_clock::time_point nextFrame; //the target start time of the next frame
+	SpinPolicy policy;
+
+	//telemetry since the last reset:
+	int frames;
+	int missed;
+	double latenessSum;
+	double latenessSqSum;
+	double maxLateness;
+};
+
+//---------------------------------------------------------------//
+
+void init_pacer(FramePacer* pacer, double hz, SpinPolicy policy); //sets up the pacer to start frames hz times a second, with the first one due now
+void wait_for_next_frame(FramePacer* pacer); //waits until the next frame's target start time and records how late it actually started
+void restart_pacer(FramePacer* pacer); //makes the next frame due now, without counting it as missed
+PacingStats get_pacing_stats(const FramePacer* pacer); //returns the telemetry since the last reset
+void reset_pacing_stats(FramePacer* pacer); //clears the telemetry
+bool parse_spin_policy(const char* name, SpinPolicy* policy); //converts "sleep", "yield" or "spin" to a policy; returns true on success, false on failure
\ No newline at end of file
@@ -1,5 +1,8 @@
 #include "particles.h"
 #include "simulation.h"
+#include "elements.h"
+#include "reactions.h"
+#include <algorithm>
 #include <cmath>
 
 //universal constants:
@@ -7,202 +10,249 @@
 #define GRAVITY_ACCELERATION 0.1f
 #define FRICTION 0.5f
 
-//liquid constants:
-#define WATER_SPREAD_DISTANCE 4
-#define ACID_SPREAD_DISTANCE 2
-#define LAVA_SPREAD_DISTANCE 1
-
-//acid constants:
-const int CORROSION_CONSTANTS[13] = { 0, 0, 0, 0, 50, 50, 30, 60, 0, 0, 0, 0, 0 };
-
-//moveable solid constants:
-#define SAND_SPREAD 1.5f
-#define SAND_INERTIAL_RESISTANCE 2
-#define SAND_SLIP_CHANCE 1000
-#define GUNPOWDER_SPREAD 2.0f
-#define GUNPOWDER_INERTIAL_RESISTANCE 4
-#define GUNPOWDER_SLIP_CHANCE 3000
-
-//gas constants:
-#define STEAM_BASE_HEALTH 300
-#define SMOKE_BASE_HEALTH 400
-
-//fire constants:
-#define EXTINGUISH_CHANCE 20
-#define SMOKE_CHANCE 30
-const int FLAMMABILITY_CONSTANTS[13] = {10, -2, -1, 0, 0, 12, 60, 0, 12, 0, 0, 0, 0};
-const int BASE_FIRE_HEALTH[13] = {50, 0, 0, 0, 0, 20, 200, 0, 50, 0, 0, 0, 0};
-
 //---------------------------------------------------------------//
 
+//kernel helper functions:
+template<ParticleType type>
+struct CompiledProps //reads an element's properties from the traits its kernel is compiled with, so they fold into constants
+{
+	static int spreadDistance(ParticleType) { return ElementTraits<type>::spreadDistance; }
+	static float spread(ParticleType) { return ElementTraits<type>::spread; }
+	static int inertialResistance(ParticleType) { return ElementTraits<type>::inertialResistance; }
+	static int slipChance(ParticleType) { return ElementTraits<type>::slipChance; }
+	static bool ages(ParticleType) { return ElementTraits<type>::baseHealth > 0; }
+	static bool reacts(ParticleType) { return (ElementTraits<type>::classes & ELEMENT_REACTIVE) != 0; }
+};
+
+struct LoadedProps //reads an element's properties from the element table, for custom elements and those a config file changed
+{
+	static int spreadDistance(ParticleType self) { return elements.spreadDistance[(int)self]; }
+	static float spread(ParticleType self) { return elements.spread[(int)self]; }
+	static int inertialResistance(ParticleType self) { return elements.inertialResistance[(int)self]; }
+	static int slipChance(ParticleType self) { return elements.slipChance[(int)self]; }
+	static bool ages(ParticleType self) { return elements.baseHealth[(int)self] > 0; }
+	static bool reacts(ParticleType self) { return (elements.classes[(int)self] & ELEMENT_REACTIVE) != 0; }
+};
+
+template<Kernel kernel>
+using KernelTag = std::integral_constant<Kernel, kernel>; //picks the overload of update_kernel() for an element at compile time
+template<ParticleType type>
+void update_element(int x, int y); //updates the particle of the given built-in type at the given position with its element's compiled kernel
+template<Kernel kernel>
+void update_loaded(int x, int y); //updates the particle at the given position with the given kernel, reading its properties from the element table
+void update_reacting(int x, int y); //lets a particle of an element that never moves react with its neighbors, for static elements given reactions
+template<typename Props>
+void update_kernel(int, int, ParticleType, KernelTag<Kernel::none>); //does nothing, for the elements that are never updated
+template<typename Props>
+void update_kernel(int x, int y, ParticleType self, KernelTag<Kernel::liquid>); //moves a liquid, then lets it react with its neighbors
+template<typename Props>
+void update_kernel(int x, int y, ParticleType self, KernelTag<Kernel::moveableSolid>); //lets a moveable solid react with its neighbors, then moves it
+template<typename Props>
+void update_kernel(int x, int y, ParticleType self, KernelTag<Kernel::gas>); //ages a gas if it ages and lets it react with its neighbors, then moves it
+template<typename Props>
+void update_kernel(int x, int y, ParticleType, KernelTag<Kernel::fire>); //burns down a fire, spreading it, putting it out and giving off smoke
+
 //liquid helper functions:
-void update_liquid(int x, int y, int spreadDist); //generically updates a liquid (such as water, acid, etc.)
-bool density_check(int x1, int y1, int x2, int y2); //returns true if the particle at position 1 has a greater density than that at position 2; DOES NOT CHECK FOR IN BOUNDS AND ASSUMES PARTICLE 1 IS A LIQUID
-bool lava_check(int x, int y); //returns true if the particle at the given position is lava, will turn the lava to stone if so
-bool corrosion_check(int x, int y); //returns true if the particle at the given position passed a random test and should be corroded
+template<typename Props>
+void update_liquid(int x, int y, ParticleType self); //generically updates a liquid (such as water, acid, etc.)
+template<typename Props>
+int spread_liquid(int x, int y, ParticleType self, int dir); //moves a liquid sideways in the given direction for as far as it can spread; returns its new x position
+bool density_check(int x1, int y1, int x2, int y2); //returns true if the particle at position 2 is of a liquid element with a lower density than the particle at position 1; DOES NOT CHECK FOR IN BOUNDS AND ASSUMES PARTICLE 1 IS A LIQUID
 
 //solid helper functions:
-void update_moveable_solid(int x, int y, float spread, int inrResist, int slipChance); //generically updates a moveable solid (such as sand, gunpowder, etc.)
+template<typename Props>
+void update_moveable_solid(int x, int y, ParticleType self); //generically updates a moveable solid (such as sand, gunpowder, etc.)
 
 //gas helper functions:
 void update_gas(int x, int y); //generically updates a gas (steam, smoke, etc.)
 
-//fire helper functions:
-bool flammability_check(int x, int y, bool steam); //sets the given particle on fire if it passes a random test, if steam = true then water will be turned to steam
+//aging helper functions:
+void decay_particle(int x, int y); //replaces a particle whose health ran out with what it decays to
+
+//dispatch helper functions:
+template<void (*update)(int, int)>
+int update_run(int x, int y, int length); //calls the update function on a run of particles of the same type, so the sweep dispatches once per run; follows UpdateFunction
+
+template<typename Sequence>
+struct CompiledKernels; //the update function of every built-in element compiled from its traits, indexed by type
+
+template<int... types>
+struct CompiledKernels<std::integer_sequence<int, types...>>
+{
+	static constexpr UpdateFunction update[] = { ElementTraits<(ParticleType)types>::isStatic ? NULL : update_run<update_element<(ParticleType)types>>... };
+};
+
+template<int... types> constexpr UpdateFunction CompiledKernels<std::integer_sequence<int, types...>>::update[];
+
+//global vars:
+ElementDescriptor elementDescriptors[MAX_PARTICLE_TYPES];
 
 //---------------------------------------------------------------//
 
-void update_oil(int x, int y)
+Particle new_particle(ParticleType type)
 {
-	update_liquid(x, y, WATER_SPREAD_DISTANCE);
+	//set universally default values:
+	Particle p;
+	p.type = type;
+	p.xVel = 0.0f;
+	p.yVel = 0.0f;
+	p.updated = false;
+
+	//set the type-specific default values from the element's traits:
+	p.flag = elements.flag[(int)type];
+	p.color = elements.color[(int)type];
+
+	if (elements.kernel[(int)type] == Kernel::moveableSolid)
+		p.freeFall = false;
+	p.health = elements.baseHealth[(int)type]; //set even for elements that don't age, since custom fires without a lifetime still read it
+	if (elements.kernel[(int)type] == Kernel::fire)
+	{
+		p.oldType = ParticleType::empty;
+		p.oldFlag = ParticleFlag::empty;
+		p.oldColor = EMPTY_COLOR;
+	}
+
+	return p;
 }
 
-void update_water(int x, int y)
+void age_particle(int x, int y)
 {
-	update_liquid(x, y, WATER_SPREAD_DISTANCE);
+	Particle* p = get_p(x, y);
+	if (!(elements.classes[(int)p->type] & ELEMENT_AGING))
+		return;
 
-	if (lava_check(x, y + 1) || lava_check(x, y - 1) ||
-		lava_check(x + 1, y) || lava_check(x - 1, y))
+	if (p->health <= 0)
 	{
-		Particle steam;
-		steam.type = ParticleType::steam;
-		steam.flag = ParticleFlag::gas;
-		steam.color = STEAM_COLOR;
-		steam.health = 300;
-		*get_p(x, y) = steam;
+		decay_particle(x, y);
+		return;
 	}
+
+	p->health--;
+	mark_changed(x, y);
 }
 
-void update_acid(int x, int y)
+void build_descriptors()
 {
-	update_liquid(x, y, ACID_SPREAD_DISTANCE);
+	const UpdateFunction loadedKernels[] = { NULL, update_run<update_loaded<Kernel::liquid>>, update_run<update_loaded<Kernel::moveableSolid>>,
+	                                         update_run<update_loaded<Kernel::gas>>, update_run<update_loaded<Kernel::fire>> };
 
-	if (corrosion_check(x, y + 1) ||
-		corrosion_check(x + 1, y) || corrosion_check(x - 1, y))
+	for (int i = 0; i < MAX_PARTICLE_TYPES; i++)
 	{
-		Particle toxicGas;
-		toxicGas.type = ParticleType::toxicGas;
-		toxicGas.flag = ParticleFlag::gas;
-		toxicGas.color = TOXIC_GAS_COLOR;
-		*get_p(x, y) = toxicGas;
+		ElementDescriptor& descriptor = elementDescriptors[i];
+		if (i >= elements.count || (elements.isStatic[i] && !(elements.classes[i] & ELEMENT_REACTIVE)))
+		{
+			descriptor = { NULL, 0, true };
+			continue;
+		}
+
+		//static elements with reactions are visited by the sweep only to react:
+		if (elements.isStatic[i])
+		{
+			descriptor = { update_run<update_reacting>, elements.classes[i], false };
+			continue;
+		}
+
+		//built-in elements nothing changed keep the kernels compiled from their traits:
+		if (i < BUILTIN_ELEMENT_COUNT && !elements.loaded[i])
+			descriptor.update = CompiledKernels<ElementSequence>::update[i];
+		else
+			descriptor.update = loadedKernels[(int)elements.kernel[i]];
+
+		descriptor.classes = elements.classes[i];
+		descriptor.isStatic = false;
 	}
 }
 
-void update_lava(int x, int y)
-{
-	update_liquid(x, y, LAVA_SPREAD_DISTANCE);
+//---------------------------------------------------------------//
 
-	flammability_check(x, y + 1, false);
-	flammability_check(x + 1, y, false);
-	flammability_check(x - 1, y, false);
+template<ParticleType type>
+void update_element(int x, int y)
+{
+	update_kernel<CompiledProps<type>>(x, y, type, KernelTag<ElementTraits<type>::kernel>());
 }
 
-void update_sand(int x, int y)
+template<Kernel kernel>
+void update_loaded(int x, int y)
 {
-	update_moveable_solid(x, y, SAND_SPREAD, SAND_INERTIAL_RESISTANCE, SAND_SLIP_CHANCE);
+	update_kernel<LoadedProps>(x, y, get_p(x, y)->type, KernelTag<kernel>());
 }
 
-void update_gunpowder(int x, int y)
+void update_reacting(int x, int y)
 {
-	update_moveable_solid(x, y, GUNPOWDER_SPREAD, GUNPOWDER_INERTIAL_RESISTANCE, GUNPOWDER_SLIP_CHANCE);
+	react(x, y);
 }
 
-void update_toxic_gas(int x, int y)
+template<typename Props>
+void update_kernel(int, int, ParticleType, KernelTag<Kernel::none>)
 {
-	update_gas(x, y);
+	//static elements are skipped by the sweep, so this is never called
 }
 
-void update_steam(int x, int y)
+template<typename Props>
+void update_kernel(int x, int y, ParticleType self, KernelTag<Kernel::liquid>)
 {
-	Particle* p = get_p(x, y);
-
-	//check and set updated:
-	if (p->updated)
+	//react before moving, leaving whatever the liquid turned into for the next tick; the check folds away for compiled elements that never react:
+	if (Props::reacts(self) && react(x, y))
 		return;
-	p->updated = true;
 
-	if (p->health <= 0)
-	{
-		Particle water;
-		water.type = ParticleType::water;
-		water.flag = ParticleFlag::liquid;
-		water.color = WATER_COLOR;
-		water.yVel = 0.0f;
-		*p = water;
+	update_liquid<Props>(x, y, self);
+}
 
+template<typename Props>
+void update_kernel(int x, int y, ParticleType self, KernelTag<Kernel::moveableSolid>)
+{
+	//react before moving, like liquids:
+	if (Props::reacts(self) && react(x, y))
 		return;
-	}
-	p->health--;
 
-	update_gas(x, y);
+	update_moveable_solid<Props>(x, y, self);
 }
 
-void update_smoke(int x, int y)
+template<typename Props>
+void update_kernel(int x, int y, ParticleType self, KernelTag<Kernel::gas>)
 {
-	Particle* p = get_p(x, y);
+	if (Props::ages(self))
+	{
+		Particle* p = get_p(x, y);
 
-	//check and set updated:
-	if (p->updated)
-		return;
-	p->updated = true;
+		//check and set updated:
+		if (p->updated)
+			return;
+		p->updated = true;
 
-	if (p->health <= 0)
-	{
-		set_empty(x, y);
-		return;
+		if (p->health <= 0)
+		{
+			decay_particle(x, y);
+			return;
+		}
+		p->health--;
 	}
-	p->health--;
+
+	if (Props::reacts(self) && react(x, y))
+		return;
 
 	update_gas(x, y);
 }
 
-void update_fire(int x, int y)
+template<typename Props>
+void update_kernel(int x, int y, ParticleType, KernelTag<Kernel::fire>)
 {
 	Particle* p = get_p(x, y);
 
 	//check if dead:
 	if (p->health <= 0)
 	{
-		set_empty(x, y);
+		decay_particle(x, y);
 		return;
 	}
 	p->health--;
 
-	//try to spread and destroy if in contact with liquid:
-	if (flammability_check(x, y + 1, true) || flammability_check(x, y - 1, true) ||
-		flammability_check(x + 1, y, true) || flammability_check(x - 1, y, true) ||
-		flammability_check(x + 1, y + 1, true) || flammability_check(x + 1, y - 1, true) ||
-		flammability_check(x - 1, y + 1, true) || flammability_check(x - 1, y - 1, true))
-	{
-		Particle newP;
-		newP.type = p->oldType;
-		newP.flag = p->oldFlag;
-		newP.color = p->oldColor;
-		newP.xVel = 0.0f;
-		newP.yVel = 0.0f;
-
-		*p = newP;
-	}
-
-	//try to spawn smoke:
-	if (rand() % SMOKE_CHANCE == 1)
-	{
-		Particle smoke;
-		smoke.type = ParticleType::smoke;
-		smoke.flag = ParticleFlag::gas;
-		smoke.color = SMOKE_COLOR;
-		smoke.health = SMOKE_BASE_HEALTH;
-
-		if (in_bounds(x, y - 1) && get_p(x, y - 1)->flag == ParticleFlag::empty)
-			*get_p(x, y - 1) = smoke;
-		else if (in_bounds(x, y + 1) && get_p(x, y + 1)->flag == ParticleFlag::empty)
-			*get_p(x, y + 1) = smoke;
-	}
+	//spread, go out or give off smoke:
+	react(x, y);
 }
 
-//---------------------------------------------------------------//
-
-void update_liquid(int x, int y, int spreadDist)
+template<typename Props>
+void update_liquid(int x, int y, ParticleType self)
 {
 	int dir = rand() % 2 == 0 ? 1 : -1; //random direction for setting xVel and diagonal moving
 	Particle* p = get_p(x, y);
@@ -210,7 +260,19 @@ void update_liquid(int x, int y, int spreadDist)
 	//updating y and yVel:
 	bool fell = false; //for telling if the particle fell vertically
 	p->yVel = fmin(p->yVel + GRAVITY_ACCELERATION, MAX_VELOCITY);
-	for (int i = 0; i < round(p->yVel) + 1; i++)
+
+	//fall through every empty cell below in a single move, then step through anything else:
+	int drop = count_empty_run(x, y, 0, 1, (int)round(p->yVel) + 1);
+	if (drop > 0)
+	{
+		swap(x, y, x, y + drop);
+		y += drop;
+
+		p = get_p(x, y);
+		fell = true;
+	}
+
+	for (int i = drop; i < round(p->yVel) + 1; i++)
 	{
 		if (in_bounds(x, y + 1) && (get_p(x, y + 1)->flag == ParticleFlag::empty || density_check(x, y, x, y + 1)))
 		{
@@ -246,75 +308,39 @@ void update_liquid(int x, int y, int spreadDist)
 			x -= dir;
 		}
 		else if (in_bounds(x + dir, y) && (get_p(x + dir, y)->flag == ParticleFlag::empty || density_check(x, y, x + dir, y)))
-		{
-			swap(x, y, x + dir, y);
-			x += dir;
-
-			//iterate to find furthest lateral movement location
-			for (int i = 1; i < spreadDist; i++)
-			{
-				if (in_bounds(x + dir, y) && (get_p(x + dir, y)->flag == ParticleFlag::empty || density_check(x, y, x + dir, y)))
-				{
-					swap(x, y, x + dir, y);
-					x += dir;
-				}
-				else
-					break;
-			}
-		}
+			x = spread_liquid<Props>(x, y, self, dir);
 		else if (in_bounds(x - dir, y) && (get_p(x - dir, y)->flag == ParticleFlag::empty || density_check(x, y, x - dir, y)))
-		{
-			swap(x, y, x - dir, y);
-			x -= dir;
-
-			//iterate to find furthest lateral movement location
-			for (int i = 1; i < spreadDist; i++)
-			{
-				if (in_bounds(x - dir, y) && (get_p(x - dir, y)->flag == ParticleFlag::empty || density_check(x, y, x - dir, y)))
-				{
-					swap(x, y, x - dir, y);
-					x -= dir;
-				}
-				else
-					break;
-			}
-		}
+			x = spread_liquid<Props>(x, y, self, -dir);
 	}
 }
 
-bool density_check(int x1, int y1, int x2, int y2)
+template<typename Props>
+int spread_liquid(int x, int y, ParticleType self, int dir)
 {
-	return get_p(x1, y1)->type > get_p(x2, y2)->type;
-}
+	const int spreadDist = Props::spreadDistance(self);
 
-bool lava_check(int x, int y)
-{
-	if (in_bounds(x, y) && get_p(x, y)->type == ParticleType::lava)
+	//iterate to find furthest lateral movement location, crossing runs of empty cells in a single move:
+	int moved = 0;
+	while (moved < spreadDist && in_bounds(x + dir, y) && (get_p(x + dir, y)->flag == ParticleFlag::empty || density_check(x, y, x + dir, y)))
 	{
-		Particle stone;
-		stone.type = ParticleType::stone;
-		stone.flag = ParticleFlag::solid;
-		stone.color = STONE_COLOR;
-		*get_p(x, y) = stone;
-		return true;
+		int run = std::max(count_empty_run(x, y, dir, 0, spreadDist - moved), 1);
+		swap(x, y, x + dir * run, y);
+		x += dir * run;
+		moved += run;
 	}
 
-	return false;
+	return x;
 }
 
-bool corrosion_check(int x, int y)
+bool density_check(int x1, int y1, int x2, int y2)
 {
-	if (in_bounds(x, y) && CORROSION_CONSTANTS[(int)get_p(x, y)->type] > 0 &&
-		rand() % CORROSION_CONSTANTS[(int)get_p(x, y)->type] == 1)
-	{
-		set_empty(x, y);
-		return true;
-	}
-
-	return false;
+	int type1 = (int)get_p(x1, y1)->type;
+	int type2 = (int)get_p(x2, y2)->type;
+	return elements.flag[type2] == ParticleFlag::liquid && elements.density[type1] > elements.density[type2];
 }
 
-void update_moveable_solid(int x, int y, float spread, int inrResist, int slipChance)
+template<typename Props>
+void update_moveable_solid(int x, int y, ParticleType self)
 {
 	int dir = rand() % 2 == 0 ? 1 : -1; //random direction for setting xVel and diagonal moving
 	Particle* p = get_p(x, y);
@@ -345,7 +371,19 @@ void update_moveable_solid(int x, int y, float spread, int inrResist, int slipCh
 	//updating y and yVel:
 	bool fell = false; //for telling if the particle fell vertically
 	p->yVel = fmin(p->yVel + GRAVITY_ACCELERATION, MAX_VELOCITY);
-	for (int i = 0; i < round(p->yVel) + 1; i++)
+
+	//fall through every empty cell below in a single move, then step through liquids and gases:
+	int drop = count_empty_run(x, y, 0, 1, (int)round(p->yVel) + 1);
+	if (drop > 0)
+	{
+		swap(x, y, x, y + drop);
+		y += drop;
+
+		p = get_p(x, y);
+		fell = true;
+	}
+
+	for (int i = drop; i < round(p->yVel) + 1; i++)
 	{
 		if (in_bounds(x, y + 1) && get_p(x, y + 1)->flag != ParticleFlag::solid)
 		{
@@ -357,14 +395,14 @@ void update_moveable_solid(int x, int y, float spread, int inrResist, int slipCh
 		}
 		else
 		{
-			p->xVel = p->yVel * dir / spread;
+			p->xVel = p->yVel * dir / Props::spread(self);
 			p->yVel = 0.0;
 			break;
 		}
 	}
 
 	//checking for diagonal movement (add random chance to slip):
-	if (!fell && (p->freeFall || (rand() % slipChance) == 1))
+	if (!fell && (p->freeFall || (rand() % Props::slipChance(self)) == 1))
 	{
 		if (in_bounds(x + dir, y + 1) && get_p(x + dir, y + 1)->flag != ParticleFlag::solid)
 		{
@@ -390,14 +428,23 @@ void update_moveable_solid(int x, int y, float spread, int inrResist, int slipCh
 	//setting freeFall for nearby particles:
 	if (p->freeFall)
 	{
-		bool change = rand() % inrResist == 1;
+		bool change = rand() % Props::inertialResistance(self) == 1;
 
 		if (in_bounds(x, y + 1) && get_p(x, y + 1)->flag == ParticleFlag::solid && !get_p(x, y + 1)->freeFall)
+		{
 			get_p(x, y + 1)->freeFall = change;
+			mark_changed(x, y + 1);
+		}
 		if (in_bounds(x + 1, y) && get_p(x + 1, y)->flag == ParticleFlag::solid && !get_p(x + 1, y)->freeFall)
+		{
 			get_p(x + 1, y)->freeFall = change;
+			mark_changed(x + 1, y);
+		}
 		if (in_bounds(x - 1, y) && get_p(x - 1, y)->flag == ParticleFlag::solid && !get_p(x - 1, y)->freeFall)
+		{
 			get_p(x - 1, y)->freeFall = change;
+			mark_changed(x - 1, y);
+		}
 	}
 }
 
@@ -439,53 +486,27 @@ void update_gas(int x, int y)
 	}
 }
 
-bool flammability_check(int x, int y, bool steam)
+void decay_particle(int x, int y)
 {
-	if (in_bounds(x, y))
+	ParticleType decaysTo = elements.decaysTo[(int)get_p(x, y)->type];
+	if (decaysTo == ParticleType::empty)
+		set_empty(x, y);
+	else
+		set_p(x, y, new_particle(decaysTo));
+}
+
+template<void (*update)(int, int)>
+int update_run(int x, int y, int length)
+{
+	ParticleType type = get_p(x, y)->type;
+
+	//an update can change the particles above, so check each one is still of the run's type before updating it:
+	int count = 0;
+	while (count < length && get_p(x, y - count)->type == type)
 	{
-		switch (FLAMMABILITY_CONSTANTS[(int)get_p(x, y)->type])
-		{
-		case 0: //do nothing due to 0 flammability chance
-			return false;
-		case -1: //destroy due to liquid contact
-			if (steam && rand() % EXTINGUISH_CHANCE == 1)
-			{
-				return true;
-			}
-			return false;
-		case -2: //destroy and spawn steam due to water contact
-			if (steam && rand() % EXTINGUISH_CHANCE == 1)
-			{
-				Particle steam;
-				steam.type = ParticleType::steam;
-				steam.flag = ParticleFlag::gas;
-				steam.color = STEAM_COLOR;
-				steam.health = STEAM_BASE_HEALTH;
-				*get_p(x, y) = steam;
-
-				return true;
-			}
-			return false;
-		default: //check for random spread chance and set to fire
-		{
-			if (rand() % FLAMMABILITY_CONSTANTS[(int)get_p(x, y)->type] == 1)
-			{
-				Particle* oldP = get_p(x, y);
-				Particle newFire;
-				newFire.type = ParticleType::fire;
-				newFire.flag = ParticleFlag::solid;
-				newFire.color = FIRE_COLOR;
-				newFire.health = BASE_FIRE_HEALTH[(int)oldP->type];
-				newFire.oldType = oldP->type;
-				newFire.oldFlag = oldP->flag;
-				newFire.oldColor = oldP->color;
-
-				*oldP = newFire;
-			}
-			return false;
-		}
-		}
+		update(x, y - count);
+		count++;
 	}
 
-	return false;
+	return count;
 }
\ No newline at end of file
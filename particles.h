@@ -1,7 +1,10 @@
 #pragma once
 #include "SDL.h"
 
-enum class ParticleType //represents all of the types of particles simulated
+//particle constants:
+#define MAX_PARTICLE_TYPES 256 //the built-in types and any custom ones loaded at startup, which fit in a byte
+
+enum class ParticleType //represents all of the built-in types of particles simulated, custom types loaded at startup follow empty
 {
 	oil = 0,
 	water = 1,
@@ -51,15 +54,27 @@ struct Particle //represents a single particle in the simuation
 	};
 };
 
+//element class flags:
+#define ELEMENT_LIQUID 0x01
+#define ELEMENT_GRANULAR 0x02 //sand and gunpowder, the moveable solids
+#define ELEMENT_GAS 0x04
+#define ELEMENT_REACTIVE 0x08 //changes its neighbors: acid, lava and fire
+#define ELEMENT_AGING 0x10 //counts down its health: fire, steam and smoke
+
+typedef int (*UpdateFunction)(int x, int y, int length); //updates up to length particles of the same type upward from the given position, stopping early at one that changed type; returns the number updated
+
+struct ElementDescriptor //how the simulation treats every particle of a type
+{
+	UpdateFunction update; //NULL for static types
+	Uint8 classes; //the ELEMENT_ class flags
+	bool isStatic; //whether or not the sweep skips particles of this type without updating them
+};
+
+extern ElementDescriptor elementDescriptors[MAX_PARTICLE_TYPES]; //the descriptor of every particle type, indexed by type; built by build_descriptors()
+
 //---------------------------------------------------------------//
 
-void update_oil(int x, int y); //updates the oil particle at the given position
-void update_water(int x, int y); //updates the water particle at the given position
-void update_acid(int x, int y); //updates the acid particle at the given position
-void update_lava(int x, int y); //updates the lava particle at the given position
-void update_sand(int x, int y); //updates the sand particle at the given position
-void update_gunpowder(int x, int y); //updates the gunpowder particle at the given position
-void update_toxic_gas(int x, int y); //updates the toxic gas particle at the given position
-void update_steam(int x, int y); //updates the steam particle at the given position
-void update_smoke(int x, int y); //updates the smoke particle at the given position
-void update_fire(int x, int y); //updates the fire particle at the given position
\ No newline at end of file
+Particle new_particle(ParticleType type); //returns a particle of the given type with its default values
+void build_descriptors(); //builds the descriptor of every type in the element table, using the kernels compiled from an element's traits unless its properties were loaded from a config file
+
+void age_particle(int x, int y); //counts down the health of fire, steam and smoke, for engines that don't run the element kernels
\ No newline at end of file
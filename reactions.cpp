@@ -0,0 +1,257 @@
+#include "reactions.h"
+#include "simulation.h"
+#include "frame_stats.h"
+#include "elements.h"
+#include "bits.h"
+#include <cstdlib>
+#include <vector>
+
+//fire constants:
+#define EXTINGUISH_CHANCE 20
+#define SMOKE_CHANCE 30
+
+//the offsets of every neighbor, in the order of the NEIGHBOR_ bits:
+static const int NEIGHBOR_X[8] = { 0, 0, 1, -1, 1, 1, -1, -1 };
+static const int NEIGHBOR_Y[8] = { -1, 1, 0, 0, 1, -1, 1, -1 };
+
+//global vars:
+static std::vector<ReactionRule> reactionTable; //the rule of every pair of elements, a row of tableStride rules per element
+static int tableStride; //the number of elements the table was built for
+static Uint8 rowNeighbors[MAX_PARTICLE_TYPES]; //the NEIGHBOR_ bits any reaction of an element can happen from, so only those are gathered
+
+//---------------------------------------------------------------//
+
+ReactionRule derive_reaction(int type, int other); //works out how an element reacts to another from their properties
+ReactionRule make_rule(int product, int otherProduct, int oneIn, Uint8 neighbors, Uint8 counted); //returns a rule happening one in oneIn times
+bool is_candidate(const ReactionRule* rule, const ReactionRule* const* candidates, int count); //returns true if the rule was already gathered, false otherwise
+bool react_with(int x, int y, int otherX, int otherY, Uint32 roll); //applies the reaction the first particle has with the second if the roll passes; returns true if one happened
+void apply_reaction(const ReactionRule& rule, int x, int y, int otherX, int otherY); //turns both particles into the rule's products and counts the reaction
+void apply_product(int x, int y, int product); //turns the particle at the given position into the given product
+void ignite(int x, int y); //sets the given particle on fire, remembering what it was
+void revert_fire(int x, int y); //puts out the fire at the given position, restoring what was burning
+
+void build_reactions()
+{
+	tableStride = elements.count;
+	reactionTable.resize((size_t)tableStride * tableStride);
+
+	for (int type = 0; type < tableStride; type++)
+	{
+		rowNeighbors[type] = 0;
+		for (int other = 0; other < tableStride; other++)
+		{
+			ReactionRule rule = derive_reaction(type, other);
+			reactionTable[type * tableStride + other] = rule;
+			if (rule.chance > 0)
+				rowNeighbors[type] |= rule.neighbors;
+		}
+
+		//only elements with a row of their own gather their neighbors:
+		if (rowNeighbors[type])
+			elements.classes[type] |= ELEMENT_REACTIVE;
+		else
+			elements.classes[type] &= ~ELEMENT_REACTIVE;
+	}
+}
+
+void set_reaction(int type, int other, const ReactionRule& rule)
+{
+	reactionTable[type * tableStride + other] = rule;
+	if (rule.chance > 0)
+	{
+		rowNeighbors[type] |= rule.neighbors;
+		elements.classes[type] |= ELEMENT_REACTIVE;
+	}
+}
+
+bool react(int x, int y)
+{
+	Particle* grid = get_grid();
+	int idx = x + y * WIDTH;
+	int type = (int)grid[idx].type;
+	const ReactionRule* rules = &reactionTable[type * tableStride];
+
+	//gather the neighbors that can react in one pass, skipping the bounds checks away from the edges:
+	bool interior = x > 0 && x < WIDTH - 1 && y > 0 && y < HEIGHT - 1;
+	const ReactionRule* candidates[8];
+	int candidateDirs[8];
+	int candidateCount = 0;
+	int total = 0;
+	for (Uint64 neighbors = rowNeighbors[type]; neighbors; neighbors &= neighbors - 1)
+	{
+		int i = lowest_bit(neighbors);
+		if (!interior && !in_bounds(x + NEIGHBOR_X[i], y + NEIGHBOR_Y[i]))
+			continue;
+
+		const ReactionRule& rule = rules[(int)grid[idx + NEIGHBOR_X[i] + NEIGHBOR_Y[i] * WIDTH].type];
+		if (rule.chance == 0 || !(rule.neighbors & (1 << i)) || (rule.once && is_candidate(&rule, candidates, candidateCount)))
+			continue;
+
+		candidates[candidateCount] = &rule;
+		candidateDirs[candidateCount] = i;
+		candidateCount++;
+		total += rule.chance;
+	}
+
+	if (total == 0)
+		return false;
+
+	//a single roll picks the reaction, each one getting a slice as wide as its chance:
+	int roll = rand() % REACTION_ROLL_RANGE;
+	for (int i = 0; i < candidateCount; i++)
+	{
+		const ReactionRule& rule = *candidates[i];
+		if (roll < rule.chance)
+		{
+			int dir = candidateDirs[i];
+			apply_reaction(rule, x, y, x + NEIGHBOR_X[dir], y + NEIGHBOR_Y[dir]);
+			return rule.product != PRODUCT_UNCHANGED;
+		}
+
+		roll -= rule.chance;
+	}
+
+	return false;
+}
+
+void react_pair(int x1, int y1, int x2, int y2, Uint32 roll)
+{
+	if (!react_with(x1, y1, x2, y2, roll))
+		react_with(x2, y2, x1, y1, roll >> 16);
+}
+
+//---------------------------------------------------------------//
+
+ReactionRule derive_reaction(int type, int other)
+{
+	const Uint8 orthogonal = NEIGHBOR_BELOW | NEIGHBOR_ABOVE | NEIGHBOR_RIGHT | NEIGHBOR_LEFT;
+	const Uint8 belowAndSides = NEIGHBOR_BELOW | NEIGHBOR_RIGHT | NEIGHBOR_LEFT;
+	int flammability = elements.flammability[other];
+
+	//boil liquids that boil, cooling to stone:
+	if (elements.ignites[type] && elements.flag[type] == ParticleFlag::liquid && elements.boils[other])
+		return make_rule((int)ParticleType::stone, (int)ParticleType::steam, 1, orthogonal, (1 << (int)Reaction::lavaToStone) | (1 << (int)Reaction::waterToSteam));
+
+	//corrode, turning to toxic gas:
+	if (elements.corrodes[type] && elements.corrosion[other] > 0)
+		return make_rule((int)ParticleType::toxicGas, (int)ParticleType::empty, elements.corrosion[other], belowAndSides, 1 << (int)Reaction::acidToToxicGas);
+
+	//set flammable neighbors alight:
+	if (elements.ignites[type] && flammability > 0)
+		return make_rule(PRODUCT_UNCHANGED, PRODUCT_BURNING, flammability, belowAndSides, 1 << (int)Reaction::ignition);
+
+	//spread, go out in contact with liquid and give off smoke:
+	if (elements.kernel[type] == Kernel::fire)
+	{
+		if (flammability > 0)
+			return make_rule(PRODUCT_UNCHANGED, PRODUCT_BURNING, flammability, NEIGHBORS_ALL, 1 << (int)Reaction::ignition);
+		if (flammability == -1)
+			return make_rule(PRODUCT_EXTINGUISHED, PRODUCT_UNCHANGED, EXTINGUISH_CHANCE, NEIGHBORS_ALL, 0);
+		if (flammability == -2)
+			return make_rule(PRODUCT_EXTINGUISHED, (int)ParticleType::steam, EXTINGUISH_CHANCE, NEIGHBORS_ALL, 1 << (int)Reaction::waterToSteam);
+		if (other == (int)ParticleType::empty)
+		{
+			//one chance of smoke a tick, going above if there's room and below otherwise:
+			ReactionRule rule = make_rule(PRODUCT_UNCHANGED, (int)ParticleType::smoke, SMOKE_CHANCE, NEIGHBOR_ABOVE | NEIGHBOR_BELOW, 0);
+			rule.once = true;
+			return rule;
+		}
+	}
+
+	return make_rule(PRODUCT_UNCHANGED, PRODUCT_UNCHANGED, 0, 0, 0);
+}
+
+ReactionRule make_rule(int product, int otherProduct, int oneIn, Uint8 neighbors, Uint8 counted)
+{
+	ReactionRule rule;
+	rule.product = (Sint16)product;
+	rule.otherProduct = (Sint16)otherProduct;
+	rule.chance = oneIn > 0 ? (Uint16)(REACTION_ROLL_RANGE / oneIn) : 0;
+	rule.neighbors = neighbors;
+	rule.counted = counted;
+	rule.once = false;
+
+	return rule;
+}
+
+bool is_candidate(const ReactionRule* rule, const ReactionRule* const* candidates, int count)
+{
+	for (int i = 0; i < count; i++)
+		if (candidates[i] == rule)
+			return true;
+
+	return false;
+}
+
+bool react_with(int x, int y, int otherX, int otherY, Uint32 roll)
+{
+	const ReactionRule& rule = reactionTable[(int)get_p(x, y)->type * tableStride + (int)get_p(otherX, otherY)->type];
+	if (rule.chance == 0 || (int)(roll % REACTION_ROLL_RANGE) >= rule.chance)
+		return false;
+
+	//only react from the neighbors the rule allows:
+	for (int i = 0; i < 8; i++)
+		if (x + NEIGHBOR_X[i] == otherX && y + NEIGHBOR_Y[i] == otherY)
+		{
+			if (!(rule.neighbors & (1 << i)))
+				return false;
+
+			apply_reaction(rule, x, y, otherX, otherY);
+			return true;
+		}
+
+	return false;
+}
+
+void apply_reaction(const ReactionRule& rule, int x, int y, int otherX, int otherY)
+{
+	apply_product(otherX, otherY, rule.otherProduct);
+	apply_product(x, y, rule.product);
+
+	for (int i = 0; i < REACTION_COUNT; i++)
+		if (rule.counted & (1 << i))
+			count_reaction((Reaction)i);
+}
+
+void apply_product(int x, int y, int product)
+{
+	switch (product)
+	{
+	case PRODUCT_UNCHANGED:
+		break;
+	case PRODUCT_BURNING:
+		ignite(x, y);
+		break;
+	case PRODUCT_EXTINGUISHED:
+		revert_fire(x, y);
+		break;
+	default:
+		if (product == (int)ParticleType::empty)
+			set_empty(x, y);
+		else
+			set_p(x, y, new_particle((ParticleType)product));
+		break;
+	}
+}
+
+void ignite(int x, int y)
+{
+	Particle* oldP = get_p(x, y);
+	Particle newFire = new_particle(ParticleType::fire);
+	newFire.health = elements.fireHealth[(int)oldP->type];
+	newFire.oldType = oldP->type;
+	newFire.oldFlag = oldP->flag;
+	newFire.oldColor = oldP->color;
+
+	set_p(x, y, newFire);
+}
+
+void revert_fire(int x, int y)
+{
+	Particle* p = get_p(x, y);
+	Particle newP = new_particle(p->oldType);
+	newP.flag = p->oldFlag;
+	newP.color = p->oldColor;
+
+	set_p(x, y, newP);
+}
\ No newline at end of file
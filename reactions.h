@@ -0,0 +1,37 @@
+#pragma once
+#include "particles.h"
+
+//reaction constants:
+#define REACTION_ROLL_RANGE 32768 //reaction chances are out of this many, the most rand() is guaranteed to cover
+#define REACTION_ALWAYS REACTION_ROLL_RANGE //the chance of a reaction that happens whenever it can
+
+//the neighbors a reaction can happen with, one bit each in the order the neighborhood is gathered:
+#define NEIGHBOR_ABOVE 0x01
+#define NEIGHBOR_BELOW 0x02
+#define NEIGHBOR_RIGHT 0x04
+#define NEIGHBOR_LEFT 0x08
+#define NEIGHBOR_DIAGONALS 0xF0
+#define NEIGHBORS_ALL 0xFF
+
+//reaction products that aren't a plain particle type:
+#define PRODUCT_UNCHANGED -1 //leaves the particle as it is
+#define PRODUCT_BURNING -2 //sets the particle on fire, remembering what it was
+#define PRODUCT_EXTINGUISHED -3 //puts out a fire, restoring what was burning
+
+struct ReactionRule //what happens when an element meets another, keyed by the pair of types
+{
+	Sint16 product; //what the element turns into, a type or a PRODUCT_ value
+	Sint16 otherProduct; //what the other element turns into, a type or a PRODUCT_ value
+	Uint16 chance; //out of REACTION_ROLL_RANGE, 0 if the pair doesn't react
+	Uint8 neighbors; //the NEIGHBOR_ bits of the positions the other element reacts from
+	Uint8 counted; //a bit per Reaction the stats count when it happens
+	bool once; //whether the rule gets a single chance however many neighbors it applies to, taken by the first in gather order
+};
+
+//---------------------------------------------------------------//
+
+void build_reactions(); //derives the reaction of every pair of elements in the element table from their properties; call after the table is filled and before build_descriptors()
+void set_reaction(int type, int other, const ReactionRule& rule); //replaces the reaction of an element with another, marking the element as reactive; call after build_reactions() and before build_descriptors()
+
+bool react(int x, int y); //gathers the neighbors of the particle at the given position and applies at most one of its reactions, drawing a single number from the rng if any can happen; returns true if the particle itself changed
+void react_pair(int x1, int y1, int x2, int y2, Uint32 roll); //applies any reaction between two neighboring particles, for engines that draw their own random numbers; roll stands in for the rng
\ No newline at end of file
@@ -0,0 +1,219 @@
+#include "recording.h"
+#include "snapshot.h"
+#include "elements.h"
+#include "byte_io.h"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+//global vars:
+static SDL_RWops* recordFile; //the recording being written, NULL if not recording
+static std::vector<Uint8> recordBuffer; //events waiting to be written
+static Uint64 recordStart; //the tick the recording started on
+static Uint64 recordLast; //the tick of the last recorded event, relative to the start
+
+enum class RecordEvent //represents all of the events stored in a recording
+{
+	brush,
+	end
+};
+
+//---------------------------------------------------------------//
+
+void write_event(RecordEvent event, Uint64 tick); //appends an event header to the buffer, storing the tick relative to the last event
+bool flush_recording(); //writes out the buffered events; returns true on success, false on failure
+Uint32 grid_checksum(const Particle* cells); //returns a hash of the types of every cell, for checking that a replay matches
+
+bool start_recording(const char* path, Uint64 tick, Particle* cells, unsigned int seed)
+{
+	if (recordFile)
+		return false;
+
+	recordFile = SDL_RWFromFile(path, "wb");
+	if (!recordFile)
+		return false;
+
+	//write the header and the world the recording starts from:
+	std::vector<Uint8> world;
+	encode_snapshot(cells, WIDTH, HEIGHT, &world);
+
+	//snapshots drop leftover fields the particles' types don't use, some of which still get read, so start from the decoded world to match the replay exactly:
+	decode_snapshot(world.data(), world.size(), cells, WIDTH, HEIGHT);
+
+	recordBuffer.clear();
+	write_u32(RECORDING_MAGIC, &recordBuffer);
+	write_u16(RECORDING_VERSION, &recordBuffer);
+	write_u32(seed, &recordBuffer);
+	write_u8((Uint8)get_sim_engine(), &recordBuffer);
+	write_u8(get_granular_bitboards() ? 1 : 0, &recordBuffer);
+	write_u16((Uint16)elements.count, &recordBuffer);
+	write_u32(hash_elements(), &recordBuffer);
+	write_u32((Uint32)world.size(), &recordBuffer);
+	recordBuffer.insert(recordBuffer.end(), world.begin(), world.end());
+
+	recordStart = tick;
+	recordLast = 0;
+	if (!flush_recording())
+	{
+		SDL_RWclose(recordFile);
+		recordFile = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+void record_brush(Uint64 tick, const SimCommand& command)
+{
+	if (!recordFile)
+		return;
+
+	write_event(RecordEvent::brush, tick);
+	write_u8((Uint8)command.particleType, &recordBuffer);
+	write_u8((Uint8)command.brushSize, &recordBuffer);
+	write_zigzag(command.x, &recordBuffer);
+	write_zigzag(command.y, &recordBuffer);
+
+	if (recordBuffer.size() >= RECORDING_FLUSH_SIZE)
+		flush_recording();
+}
+
+void stop_recording(Uint64 tick, const Particle* cells)
+{
+	if (!recordFile)
+		return;
+
+	write_event(RecordEvent::end, tick);
+	write_u32(grid_checksum(cells), &recordBuffer);
+
+	flush_recording();
+	SDL_RWclose(recordFile);
+	recordFile = NULL;
+}
+
+bool is_recording()
+{
+	return recordFile != NULL;
+}
+
+bool replay_recording(const char* path, ReplayStats* stats)
+{
+	stats->ticks = 0;
+	stats->brushes = 0;
+	stats->seconds = 0.0;
+	stats->finished = false;
+	stats->matched = false;
+	stats->engine = SimEngine::sweep;
+	stats->granularBitboards = false;
+
+	std::vector<Uint8> data;
+	if (!read_file(path, &data))
+		return false;
+
+	//read the header and restore the starting world:
+	ByteReader reader = make_byte_reader(data.data(), data.size());
+	if (read_u32(&reader) != RECORDING_MAGIC || read_u16(&reader) != RECORDING_VERSION)
+		return false;
+
+	unsigned int seed = read_u32(&reader);
+	Uint8 engine = read_u8(&reader);
+	Uint8 granularBitboards = read_u8(&reader);
+
+	//the world and brush strokes refer to elements by number, so the recording needs the same ones it was made with:
+	Uint16 elementCount = read_u16(&reader);
+	Uint32 elementHash = read_u32(&reader);
+	if (!reader.failed && (elementCount != elements.count || elementHash != hash_elements()))
+	{
+		std::cout << path << " was recorded with different elements, load the same --elements file" << std::endl;
+		return false;
+	}
+
+	Uint32 worldSize = read_u32(&reader);
+	if (reader.failed || engine > (Uint8)SimEngine::margolus || granularBitboards > 1 || worldSize > reader.size - reader.pos || !decode_snapshot(reader.data + reader.pos, worldSize, get_grid(), WIDTH, HEIGHT))
+		return false;
+
+	reader.pos += worldSize;
+	reindex_grid();
+
+	//the engines and granular bitboards play out differently from the same seed, so replay with what the recording was made with:
+	stats->engine = (SimEngine)engine;
+	stats->granularBitboards = granularBitboards != 0;
+	set_sim_engine(stats->engine);
+	set_granular_bitboards(stats->granularBitboards);
+	seed_simulation(seed);
+
+	//apply each event on the tick it was recorded on, simulating the ticks in between:
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	while (reader.pos < reader.size)
+	{
+		RecordEvent event = (RecordEvent)read_u8(&reader);
+		Uint64 tick = stats->ticks + read_varint(&reader);
+		if (reader.failed)
+			break;
+
+		if (event == RecordEvent::brush)
+		{
+			ParticleType type = (ParticleType)read_u8(&reader);
+			int brushSize = read_u8(&reader);
+			int x = (int)read_zigzag(&reader);
+			int y = (int)read_zigzag(&reader);
+			if (reader.failed || (int)type >= elements.count)
+				break;
+
+			for (; stats->ticks < tick; stats->ticks++)
+				run_simulation();
+
+			add_particles(type, brushSize, x, y);
+			stats->brushes++;
+		}
+		else if (event == RecordEvent::end)
+		{
+			Uint32 checksum = read_u32(&reader);
+			if (reader.failed)
+				break;
+
+			for (; stats->ticks < tick; stats->ticks++)
+				run_simulation();
+
+			stats->finished = true;
+			stats->matched = checksum == grid_checksum(get_grid());
+			break;
+		}
+		else
+			break;
+	}
+	stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	return true;
+}
+
+//---------------------------------------------------------------//
+
+void write_event(RecordEvent event, Uint64 tick)
+{
+	tick -= recordStart;
+	write_u8((Uint8)event, &recordBuffer);
+	write_varint(tick - recordLast, &recordBuffer);
+	recordLast = tick;
+}
+
+bool flush_recording()
+{
+	bool success = SDL_RWwrite(recordFile, recordBuffer.data(), 1, recordBuffer.size()) == recordBuffer.size();
+	recordBuffer.clear();
+
+	return success;
+}
+
+Uint32 grid_checksum(const Particle* cells)
+{
+	//FNV-1a:
+	Uint32 hash = 2166136261u;
+	for (int i = 0; i < WIDTH * HEIGHT; i++)
+	{
+		hash ^= (Uint8)cells[i].type;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+#include "sim_thread.h"
+
+//recording constants:
+#define RECORDING_MAGIC 0x43525345 //"ESRC" when written in little-endian byte order
+#define RECORDING_VERSION 3
+#define RECORDING_FLUSH_SIZE 65536 //recorded events are buffered and written out once this many bytes have built up
+
+struct ReplayStats //the results of replaying a recording
+{
+	Uint64 ticks;
+	Uint64 brushes; //the number of brush commands applied
+	double seconds; //the time spent simulating, not counting loading the recording
+	bool finished; //whether or not the recording was closed properly, recordings cut short by a crash can still be replayed up to their last event
+	bool matched; //whether or not the world at the end of the replay matched the recorded one
+	SimEngine engine; //the engine the recording was made, and replayed, with
+	bool granularBitboards; //whether or not the recording was made, and replayed, with granular bitboards
+};
+
+//---------------------------------------------------------------//
+
+bool start_recording(const char* path, Uint64 tick, Particle* cells, unsigned int seed); //starts recording to the given file from the world as it is before simulating the given tick, which must have just been seeded with seed; the cells are reset to exactly what the recording stores; returns true on success, false on failure
+void record_brush(Uint64 tick, const SimCommand& command); //records a brush command applied before simulating the given tick
+void stop_recording(Uint64 tick, const Particle* cells); //records the final world state and closes the recording
+bool is_recording(); //returns true if a recording is in progress, false otherwise
+
+bool replay_recording(const char* path, ReplayStats* stats); //replays a recording into the simulation as fast as possible, without rendering, switching to the engine and granular bitboards setting it was made with; returns true on success, false if the recording couldn't be read
\ No newline at end of file
@@ -0,0 +1,210 @@
+#include "rewind.h"
+#include "simulation.h"
+#include "snapshot.h"
+#include "byte_io.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+//history layout:
+//  keyframes: a compact snapshot of the whole grid
+//  deltas: varint cell count, then for every cell the tick changed, in index order: varint gap since the previous cell's index, encoded particle
+//the history always starts with a keyframe, and old ticks are dropped a keyframe interval at a time
+
+struct RewindFrame //the stored state of the grid after a single tick
+{
+	Uint64 tick;
+	bool keyframe;
+	std::vector<Uint8> data;
+};
+
+//global vars:
+static bool rewindEnabled;
+static std::deque<RewindFrame> history; //oldest tick first
+static size_t historyBytes; //the memory used by the history
+static size_t historyLimit;
+static Uint64 lastKeyframe; //the tick of the newest keyframe
+
+static std::vector<Particle> shadow; //the cells as of the newest stored tick, for skipping cells that were written without really changing
+static std::vector<int> changes; //the cells written by the current tick
+static std::vector<Uint8> entries; //scratch space for encoding deltas
+
+//---------------------------------------------------------------//
+
+void push_keyframe(Uint64 tick, const Particle* cells); //stores a full snapshot of the cells
+void push_frame(RewindFrame& frame); //adds a frame to the history, dropping the oldest ticks if over the memory limit
+bool apply_delta(const RewindFrame& frame, Particle* cells); //writes a delta's cells into the grid; returns true on success, false if the data is corrupt
+
+void start_rewind(Uint64 tick, const Particle* cells, size_t memoryLimit)
+{
+	rewindEnabled = true;
+	historyLimit = memoryLimit;
+	track_changes(true);
+
+	reset_rewind(tick, cells);
+}
+
+void stop_rewind()
+{
+	if (!rewindEnabled)
+		return;
+
+	rewindEnabled = false;
+	track_changes(false);
+
+	history.clear();
+	historyBytes = 0;
+	std::vector<Particle>().swap(shadow);
+}
+
+void reset_rewind(Uint64 tick, const Particle* cells)
+{
+	if (!rewindEnabled)
+		return;
+
+	history.clear();
+	historyBytes = 0;
+	shadow.assign(cells, cells + WIDTH * HEIGHT);
+	take_changes(&changes);
+
+	push_keyframe(tick, cells);
+}
+
+void record_rewind_tick(Uint64 tick, const Particle* cells)
+{
+	if (!rewindEnabled)
+		return;
+
+	take_changes(&changes);
+
+	if (tick - lastKeyframe >= REWIND_KEYFRAME_INTERVAL)
+	{
+		for (int idx : changes)
+			shadow[idx] = cells[idx];
+
+		push_keyframe(tick, cells);
+		return;
+	}
+
+	//encode only the written cells that really changed, so the cost follows the activity rather than the grid size:
+	std::sort(changes.begin(), changes.end());
+
+	entries.clear();
+	size_t count = 0;
+	int next = 0; //the index the next entry's gap is measured from
+	for (int idx : changes)
+		if (memcmp(&cells[idx], &shadow[idx], sizeof(Particle)) != 0)
+		{
+			write_varint(idx - next, &entries);
+			encode_particle(cells[idx], &entries);
+			shadow[idx] = cells[idx];
+
+			next = idx + 1;
+			count++;
+		}
+
+	RewindFrame frame;
+	frame.tick = tick;
+	frame.keyframe = false;
+	frame.data.reserve(entries.size() + 10);
+	write_varint(count, &frame.data);
+	frame.data.insert(frame.data.end(), entries.begin(), entries.end());
+
+	push_frame(frame);
+}
+
+Uint64 rewind_world(Uint64 tick, Particle* cells)
+{
+	if (!rewindEnabled || history.empty())
+		return tick;
+
+	tick = std::min(std::max(tick, history.front().tick), history.back().tick);
+
+	//find the newest keyframe at or before the tick, then replay the deltas after it:
+	size_t keyframe = history.size() - 1;
+	while (!history[keyframe].keyframe || history[keyframe].tick > tick)
+		keyframe--;
+
+	const RewindFrame& frame = history[keyframe];
+	bool success = decode_snapshot(frame.data.data(), frame.data.size(), cells, WIDTH, HEIGHT);
+
+	size_t end = keyframe + 1;
+	for (; end < history.size() && history[end].tick <= tick; end++)
+		success = success && apply_delta(history[end], cells);
+
+	//the ticks after the restored one are gone for good, the simulation will play out differently from here:
+	for (size_t i = end; i < history.size(); i++)
+		historyBytes -= sizeof(RewindFrame) + history[i].data.size();
+	history.erase(history.begin() + end, history.end());
+	lastKeyframe = frame.tick;
+
+	shadow.assign(cells, cells + WIDTH * HEIGHT);
+	take_changes(&changes);
+
+	//the history is only written by this module, so corruption means a bug; start over from whatever was restored rather than keep bad history:
+	if (!success)
+		reset_rewind(tick, cells);
+
+	return tick;
+}
+
+size_t get_rewind_memory()
+{
+	return historyBytes;
+}
+
+//---------------------------------------------------------------//
+
+void push_keyframe(Uint64 tick, const Particle* cells)
+{
+	RewindFrame frame;
+	frame.tick = tick;
+	frame.keyframe = true;
+	encode_snapshot(cells, WIDTH, HEIGHT, &frame.data);
+	frame.data.shrink_to_fit();
+
+	lastKeyframe = tick;
+	push_frame(frame);
+}
+
+void push_frame(RewindFrame& frame)
+{
+	historyBytes += sizeof(RewindFrame) + frame.data.size();
+	history.push_back(std::move(frame));
+
+	//drop the oldest keyframe interval at a time so the history always starts with a keyframe, always keeping the newest one:
+	while (historyBytes > historyLimit)
+	{
+		size_t nextKeyframe = 1;
+		while (nextKeyframe < history.size() && !history[nextKeyframe].keyframe)
+			nextKeyframe++;
+		if (nextKeyframe >= history.size())
+			break;
+
+		for (size_t i = 0; i < nextKeyframe; i++)
+		{
+			historyBytes -= sizeof(RewindFrame) + history.front().data.size();
+			history.pop_front();
+		}
+	}
+}
+
+bool apply_delta(const RewindFrame& frame, Particle* cells)
+{
+	ByteReader reader = make_byte_reader(frame.data.data(), frame.data.size());
+	const size_t count = WIDTH * HEIGHT;
+
+	Uint64 entries = read_varint(&reader);
+	size_t idx = 0;
+	for (Uint64 i = 0; i < entries && !reader.failed; i++)
+	{
+		Uint64 gap = read_varint(&reader);
+		if (reader.failed || gap >= count - idx || !decode_particle(&reader, &cells[idx + gap]))
+			return false;
+
+		idx += (size_t)gap + 1;
+	}
+
+	return !reader.failed;
+}
\ No newline at end of file
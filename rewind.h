@@ -0,0 +1,17 @@
+#pragma once
+#include "particles.h"
+#include <cstddef>
+
+//rewind constants:
+#define REWIND_KEYFRAME_INTERVAL 120 //a full snapshot is kept every this many ticks, every other tick only keeps the cells it changed
+#define DEFAULT_REWIND_MEMORY 64 //the default number of megabytes of rewind history to keep
+#define DEFAULT_REWIND_STEP 5.0 //the default number of seconds the rewind command goes back
+
+//---------------------------------------------------------------//
+
+void start_rewind(Uint64 tick, const Particle* cells, size_t memoryLimit); //starts tracking changes to the grid and keeping history from the given tick on, using about memoryLimit bytes at most
+void stop_rewind(); //stops tracking changes and frees the history
+void reset_rewind(Uint64 tick, const Particle* cells); //discards the history and starts again from the given cells; call after replacing the grid without going through set_p()
+void record_rewind_tick(Uint64 tick, const Particle* cells); //stores the changes made by the tick that just ran; only call from the simulation thread, after each tick
+Uint64 rewind_world(Uint64 tick, Particle* cells); //restores the cells to how they were after the given tick, or after the oldest tick kept if the history doesn't go back that far; returns the tick restored
+size_t get_rewind_memory(); //returns the number of bytes of history currently kept
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "shared_frames.h"
+#include "elements.h"
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//global vars:
+static SharedFramesView ring; //the ring being published to
+static std::string ringName;
+static Uint64 framesPublished;
+
+//---------------------------------------------------------------//
+
+size_t ring_size(); //returns the size of a ring for this build's grid
+size_t slot_size(); //returns the distance between slots for this build's grid
+SharedFrameSlot* get_slot(const SharedFramesView& view, Uint64 frame); //returns the slot the given frame is written to
+bool map_ring(const char* name, bool create, SharedFramesView* view); //creates or opens the named shared memory and maps it, only creating it if the name is free; returns true on success, false on failure
+void report_name_in_use(const char* name); //says another ring already has the name
+void unmap_ring(SharedFramesView* view);
+
+bool start_shared_frames(const char* name)
+{
+	if (ring.base || !map_ring(name, true, &ring))
+		return false;
+
+	ringName = name;
+	framesPublished = 0;
+
+	//fill in the header last so readers never see a ring that looks complete before it is:
+	memset(ring.base, 0, ring.size);
+	SharedFramesHeader* header = new (ring.base) SharedFramesHeader;
+	header->version = SHARED_FRAMES_VERSION;
+	header->slotCount = SHARED_FRAME_SLOTS;
+	header->width = WIDTH;
+	header->height = HEIGHT;
+	header->slotSize = (Uint32)slot_size();
+	for (int i = 0; i < elements.count; i++)
+	{
+		header->palette[i][0] = elements.color[i].r;
+		header->palette[i][1] = elements.color[i].g;
+		header->palette[i][2] = elements.color[i].b;
+	}
+	header->latest.store(0, std::memory_order_relaxed);
+
+	for (int i = 0; i < SHARED_FRAME_SLOTS; i++)
+		new (get_slot(ring, i + 1)) SharedFrameSlot();
+
+	std::atomic_thread_fence(std::memory_order_release);
+	header->magic = SHARED_FRAMES_MAGIC;
+
+	return true;
+}
+
+void stop_shared_frames()
+{
+	if (!ring.base)
+		return;
+
+	unmap_ring(&ring);
+
+#ifndef _WIN32
+	shm_unlink(ringName.c_str());
+#endif
+}
+
+void publish_shared_frame(const FrameSnapshot& frame)
+{
+	if (!ring.base)
+		return;
+
+	SharedFramesHeader* header = (SharedFramesHeader*)ring.base;
+	Uint64 number = ++framesPublished;
+	SharedFrameSlot* slot = get_slot(ring, number);
+
+	//seqlock: mark the slot as being written, write it, then mark it complete:
+	slot->sequence.store(number * 2 - 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	slot->tick = frame.tick;
+	memcpy((Uint8*)slot + SHARED_FRAME_SLOT_HEADER_SIZE, frame.types, WIDTH * HEIGHT);
+
+	slot->sequence.store(number * 2, std::memory_order_release);
+	header->latest.store(number, std::memory_order_release);
+}
+
+bool open_shared_frames(const char* name, SharedFramesView* view)
+{
+	if (!map_ring(name, false, view))
+		return false;
+
+	const SharedFramesHeader* header = get_shared_header(*view);
+	if (header->magic != SHARED_FRAMES_MAGIC || header->version != SHARED_FRAMES_VERSION || header->slotCount != SHARED_FRAME_SLOTS ||
+		header->width != WIDTH || header->height != HEIGHT || header->slotSize != slot_size())
+	{
+		unmap_ring(view);
+		return false;
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+
+	return true;
+}
+
+void close_shared_frames(SharedFramesView* view)
+{
+	unmap_ring(view);
+}
+
+const SharedFramesHeader* get_shared_header(const SharedFramesView& view)
+{
+	return (const SharedFramesHeader*)view.base;
+}
+
+Uint64 get_shared_frame(const SharedFramesView& view, const Uint8** types, Uint64* tick)
+{
+	const SharedFramesHeader* header = get_shared_header(view);
+
+	//the newest frame can be overwritten while it is being looked up if the reader stalls, so retry with the next newest:
+	while (true)
+	{
+		Uint64 number = header->latest.load(std::memory_order_acquire);
+		if (number == 0)
+			return 0;
+
+		SharedFrameSlot* slot = get_slot(view, number);
+		if (slot->sequence.load(std::memory_order_acquire) != number * 2)
+			continue;
+
+		*types = (const Uint8*)slot + SHARED_FRAME_SLOT_HEADER_SIZE;
+		*tick = slot->tick;
+		return number;
+	}
+}
+
+bool shared_frame_intact(const SharedFramesView& view, Uint64 frame)
+{
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return get_slot(view, frame)->sequence.load(std::memory_order_relaxed) == frame * 2;
+}
+
+//---------------------------------------------------------------//
+
+size_t ring_size()
+{
+	return SHARED_FRAMES_HEADER_SIZE + SHARED_FRAME_SLOTS * slot_size();
+}
+
+size_t slot_size()
+{
+	//keep every slot on its own cache lines:
+	return (SHARED_FRAME_SLOT_HEADER_SIZE + WIDTH * HEIGHT + 63) / 64 * 64;
+}
+
+SharedFrameSlot* get_slot(const SharedFramesView& view, Uint64 frame)
+{
+	return (SharedFrameSlot*)((Uint8*)view.base + SHARED_FRAMES_HEADER_SIZE + ((frame - 1) % SHARED_FRAME_SLOTS) * slot_size());
+}
+
+bool map_ring(const char* name, bool create, SharedFramesView* view)
+{
+	size_t size = ring_size();
+	void* base = NULL;
+	view->handle = NULL;
+
+	//readers map the ring writable too, since 64-bit atomic loads are compare-exchanges on some 32-bit targets; they never write to it otherwise
+
+#ifdef _WIN32
+	//windows names can't contain backslashes past the namespace, and posix style names start with a slash:
+	std::string localName = std::string("Local\\") + (name[0] == '/' ? name + 1 : name);
+
+	HANDLE mapping = create ? CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)size, localName.c_str()) :
+		OpenFileMappingA(FILE_MAP_READ | FILE_MAP_WRITE, FALSE, localName.c_str());
+	if (!mapping)
+		return false;
+
+	//creating a mapping that exists opens it instead, which would reset another instance's ring:
+	if (create && GetLastError() == ERROR_ALREADY_EXISTS)
+	{
+		CloseHandle(mapping);
+		report_name_in_use(name);
+		return false;
+	}
+
+	base = MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, size);
+	if (!base)
+	{
+		CloseHandle(mapping);
+		return false;
+	}
+	view->handle = mapping;
+#else
+	int file = shm_open(name, create ? O_CREAT | O_EXCL | O_RDWR : O_RDWR, 0600);
+	if (file < 0)
+	{
+		if (create && errno == EEXIST)
+			report_name_in_use(name);
+		return false;
+	}
+
+	struct stat fileStat;
+	bool sized = create ? ftruncate(file, size) == 0 : fstat(file, &fileStat) == 0 && (size_t)fileStat.st_size == size;
+	if (sized)
+	{
+		base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+		if (base == MAP_FAILED)
+			base = NULL;
+	}
+	close(file);
+
+	if (!base)
+	{
+		if (create)
+			shm_unlink(name);
+		return false;
+	}
+#endif
+
+	view->base = base;
+	view->size = size;
+	return true;
+}
+
+void report_name_in_use(const char* name)
+{
+	std::cout << "shared frames name " << name << " is already in use, by another instance or left behind by one that crashed" << std::endl;
+}
+
+void unmap_ring(SharedFramesView* view)
+{
+	if (!view->base)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(view->base);
+	CloseHandle((HANDLE)view->handle);
+#else
+	munmap(view->base, view->size);
+#endif
+
+	view->base = NULL;
+	view->size = 0;
+	view->handle = NULL;
+}
\ No newline at end of file
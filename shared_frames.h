@@ -0,0 +1,55 @@
+#pragma once
+#include "simulation.h"
+#include <atomic>
+#include <cstddef>
+
+//shared frame constants:
+#define SHARED_FRAMES_MAGIC 0x53525345 //"ESRS" when written in little-endian byte order
+#define SHARED_FRAMES_VERSION 2
+#define SHARED_FRAME_SLOTS 8 //the number of frames kept in the ring, readers have this many frames of time to finish with one
+#define SHARED_FRAMES_HEADER_SIZE 1024 //the slots start this many bytes into the shared memory
+#define SHARED_FRAME_SLOT_HEADER_SIZE 64 //the types start this many bytes into a slot
+
+//shared memory layout, in the writer's native byte order:
+//  header: SharedFramesHeader, zero padded to SHARED_FRAMES_HEADER_SIZE
+//  slots: slotCount SharedFrameSlots, each zero padded to SHARED_FRAME_SLOT_HEADER_SIZE and followed by width * height type bytes, then padded to slotSize
+//frame n (counting from 1) is written to slot (n - 1) % slotCount; a slot's sequence is odd while it is being written and 2n once frame n is complete
+
+struct SharedFramesHeader //describes the ring, written once when it is created except for latest
+{
+	Uint32 magic;
+	Uint16 version;
+	Uint16 slotCount;
+	Uint32 width;
+	Uint32 height;
+	Uint32 slotSize; //the distance between slots in bytes
+	Uint8 palette[MAX_PARTICLE_TYPES][3]; //the rgb color of every particle type, indexed by type; black for types not in use
+	std::atomic<Uint64> latest; //the number of the newest complete frame, 0 before the first
+};
+
+static_assert(sizeof(SharedFramesHeader) <= SHARED_FRAMES_HEADER_SIZE, "the shared frame header has to fit before the slots");
+
+struct SharedFrameSlot
+{
+	std::atomic<Uint64> sequence;
+	Uint64 tick; //the simulation tick the frame was captured after
+};
+
+struct SharedFramesView //a mapping of a shared frame ring, from either side
+{
+	void* base;
+	size_t size;
+	void* handle; //the file mapping handle on windows, unused elsewhere
+};
+
+//---------------------------------------------------------------//
+
+bool start_shared_frames(const char* name); //creates the named shared memory ring and starts publishing frames to it; returns true on success, false on failure, including if a ring with the name already exists
+void stop_shared_frames(); //unmaps and removes the ring; readers that still have it mapped keep their mapping
+void publish_shared_frame(const FrameSnapshot& frame); //copies a completed frame into the next slot; never waits on readers; only call from one thread
+
+bool open_shared_frames(const char* name, SharedFramesView* view); //maps an existing ring for reading; returns true on success, false if it doesn't exist or doesn't match this build
+void close_shared_frames(SharedFramesView* view);
+const SharedFramesHeader* get_shared_header(const SharedFramesView& view); //returns the ring's header
+Uint64 get_shared_frame(const SharedFramesView& view, const Uint8** types, Uint64* tick); //points types at the newest complete frame, in place, and returns its number; returns 0 if there is none yet
+bool shared_frame_intact(const SharedFramesView& view, Uint64 frame); //returns true if the given frame hasn't started being overwritten; check after reading a frame in place, and discard what was read if it returns false
\ No newline at end of file
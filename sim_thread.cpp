@@ -0,0 +1,292 @@
+#include "sim_thread.h"
+#include "lockfree.h"
+#include "snapshot.h"
+#include "autosave.h"
+#include "recording.h"
+#include "frame_export.h"
+#include "shared_frames.h"
+#include "frame_stats.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <iostream>
+#include <thread>
+
+//global vars:
+static std::thread simThread; //the thread running the simulation
+static std::atomic<bool> simRunning; //whether or not the simulation thread should keep running
+static SimSettings simSettings; //how often the simulation thread ticks and publishes frames
+static TripleBuffer<FrameSnapshot> frames; //completed frames, passed from the simulation thread to the render thread
+static SpscQueue<SimCommand, COMMAND_QUEUE_SIZE> commands; //input commands, passed from the input thread to the simulation thread
+static Uint64 simTick; //the number of ticks simulated so far
+static Uint64 lastCommand; //the id of the newest tracked command applied so far
+static std::atomic<bool> fastForward; //whether or not the simulation is running unthrottled
+static std::atomic<double> ticksPerSecond; //the tick rate measured over the last second
+
+//---------------------------------------------------------------//
+
+void sim_thread_loop(); //the main loop of the simulation thread
+void tick(); //applies the queued commands and simulates one tick
+void apply_commands(); //applies every queued command to the grid
+void publish_frame(); //captures the grid and makes it the latest frame
+void finish_recording(); //closes the recording in progress, if any
+double lap(std::chrono::steady_clock::time_point* start); //returns the milliseconds since start and moves start to now
+
+SimSettings default_sim_settings()
+{
+	SimSettings settings;
+	settings.simHz = DEFAULT_SIM_HZ;
+	settings.displayHz = DEFAULT_DISPLAY_HZ;
+	settings.maxSubsteps = DEFAULT_MAX_SUBSTEPS;
+	settings.spinPolicy = SpinPolicy::yield;
+	settings.worldPath = DEFAULT_WORLD_PATH;
+	settings.rawSnapshots = false;
+	settings.recordingPath = DEFAULT_RECORDING_PATH;
+	settings.rewindMemory = (size_t)DEFAULT_REWIND_MEMORY * 1024 * 1024;
+	settings.rewindStep = DEFAULT_REWIND_STEP;
+
+	return settings;
+}
+
+bool start_sim_thread(const SimSettings& settings)
+{
+	simSettings = settings;
+
+	//publish the initial grid so there is always a frame to render:
+	simTick = 0;
+	lastCommand = 0;
+	ticksPerSecond = 0.0;
+	publish_frame();
+
+	if (simSettings.rewindMemory > 0)
+		start_rewind(simTick, get_grid(), simSettings.rewindMemory);
+	frames.acquire();
+
+	simRunning = true;
+	simThread = std::thread(sim_thread_loop);
+
+	return simThread.joinable();
+}
+
+void stop_sim_thread()
+{
+	simRunning = false;
+	if (simThread.joinable())
+		simThread.join();
+
+	finish_recording();
+	stop_rewind();
+}
+
+bool push_command(const SimCommand& command)
+{
+	return commands.push(command);
+}
+
+const FrameSnapshot& get_latest_frame()
+{
+	frames.acquire();
+	return frames.read_buffer();
+}
+
+void set_fast_forward(bool enabled)
+{
+	fastForward = enabled;
+}
+
+bool get_fast_forward()
+{
+	return fastForward;
+}
+
+double get_ticks_per_second()
+{
+	return ticksPerSecond;
+}
+
+//---------------------------------------------------------------//
+
+void sim_thread_loop()
+{
+	using clock = std::chrono::steady_clock;
+
+	const double tickDelay = 1.0 / simSettings.simHz; //in seconds
+	FramePacer pacer;
+	init_pacer(&pacer, simSettings.displayHz, simSettings.spinPolicy);
+	clock::time_point last = clock::now();
+	double accumulator = 0.0; //simulation time owed, in seconds
+
+	clock::time_point rateStart = last; //for measuring the tick rate
+	Uint64 rateStartTick = simTick;
+
+	while (simRunning)
+	{
+		clock::time_point now = clock::now();
+
+		//measure the achieved tick rate once a second:
+		if (now - rateStart >= std::chrono::seconds(1))
+		{
+			ticksPerSecond = (simTick - rateStartTick) / std::chrono::duration<double>(now - rateStart).count();
+			rateStart = now;
+			rateStartTick = simTick;
+		}
+
+		//when fast forwarding, tick as fast as possible and only stop to publish a frame once per display period:
+		if (fastForward)
+		{
+			clock::time_point frameEnd = now + pacer.period;
+			do
+				tick();
+			while (simRunning && clock::now() < frameEnd);
+
+			publish_frame();
+
+			last = clock::now();
+			restart_pacer(&pacer);
+			accumulator = 0.0;
+			continue;
+		}
+
+		accumulator += std::chrono::duration<double>(now - last).count();
+		last = now;
+
+		//run as many fixed ticks as the elapsed time calls for, up to the substep cap:
+		int substeps = 0;
+		while (accumulator >= tickDelay && substeps < simSettings.maxSubsteps)
+		{
+			tick();
+
+			accumulator -= tickDelay;
+			substeps++;
+		}
+
+		//drop any backlog past the cap instead of trying to catch up, keeping the partial tick:
+		if (accumulator >= tickDelay)
+			accumulator = fmod(accumulator, tickDelay);
+
+		if (substeps > 0)
+			publish_frame();
+
+		wait_for_next_frame(&pacer);
+	}
+}
+
+void tick()
+{
+	double phaseTimes[PHASE_COUNT];
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	apply_commands();
+	phaseTimes[(int)TickPhase::commands] = lap(&start);
+
+	run_simulation();
+	simTick++;
+	phaseTimes[(int)TickPhase::simulate] = lap(&start);
+
+	record_rewind_tick(simTick, get_grid());
+	phaseTimes[(int)TickPhase::history] = lap(&start);
+
+	update_autosave(get_grid());
+	update_export(simTick, get_grid());
+	phaseTimes[(int)TickPhase::output] = lap(&start);
+
+	update_stats_log(simTick, phaseTimes);
+}
+
+void apply_commands()
+{
+	SimCommand command;
+	while (commands.pop(command))
+	{
+		if (command.id != 0)
+			lastCommand = command.id;
+
+		switch (command.type)
+		{
+		case CommandType::addParticles:
+			add_particles(command.particleType, command.brushSize, command.x, command.y);
+			record_brush(simTick, command);
+			break;
+		case CommandType::saveWorld:
+			if (simSettings.rawSnapshots ? save_raw_snapshot(simSettings.worldPath, get_grid(), WIDTH, HEIGHT) : save_snapshot(simSettings.worldPath, get_grid(), WIDTH, HEIGHT))
+				std::cout << "saved world to " << simSettings.worldPath << std::endl;
+			else
+				std::cout << "failed to save world to " << simSettings.worldPath << std::endl;
+			break;
+		case CommandType::loadWorld:
+			//a load can't be replayed, so end any recording with the world as it was before:
+			finish_recording();
+
+			if (load_snapshot(simSettings.worldPath, get_grid(), WIDTH, HEIGHT))
+				std::cout << "loaded world from " << simSettings.worldPath << std::endl;
+			else
+				std::cout << "failed to load world from " << simSettings.worldPath << std::endl;
+
+			reindex_grid();
+
+			reset_rewind(simTick, get_grid());
+			break;
+		case CommandType::toggleRecording:
+			if (is_recording())
+				finish_recording();
+			else
+			{
+				//reseed so the recording only depends on the seed it stores, not on everything simulated before it:
+				unsigned int seed = (unsigned int)time(NULL);
+				seed_simulation(seed);
+
+				if (start_recording(simSettings.recordingPath, simTick, get_grid(), seed))
+					std::cout << "recording to " << simSettings.recordingPath << std::endl;
+				else
+					std::cout << "failed to start recording to " << simSettings.recordingPath << std::endl;
+			}
+			break;
+		case CommandType::rewind:
+		{
+			if (simSettings.rewindMemory == 0)
+			{
+				std::cout << "rewinding is disabled" << std::endl;
+				break;
+			}
+
+			//a rewind can't be replayed either:
+			finish_recording();
+
+			Uint64 steps = (Uint64)(simSettings.rewindStep * simSettings.simHz);
+			simTick = rewind_world(simTick > steps ? simTick - steps : 0, get_grid());
+			reindex_grid();
+			std::cout << "rewound to tick " << simTick << " (" << get_rewind_memory() / 1024 << " KB of history kept)" << std::endl;
+			break;
+		}
+		}
+	}
+}
+
+void publish_frame()
+{
+	FrameSnapshot& frame = frames.write_buffer();
+	capture_frame(&frame);
+	frame.tick = simTick;
+	frame.lastCommand = lastCommand;
+	publish_shared_frame(frame);
+	frames.publish();
+}
+
+void finish_recording()
+{
+	if (!is_recording())
+		return;
+
+	stop_recording(simTick, get_grid());
+	std::cout << "saved recording to " << simSettings.recordingPath << std::endl;
+}
+
+double lap(std::chrono::steady_clock::time_point* start)
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	double elapsed = std::chrono::duration<double, std::milli>(now - *start).count();
+	*start = now;
+
+	return elapsed;
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+#include "simulation.h"
+#include "pacer.h"
+#include "rewind.h"
+#include <chrono>
+
+//simulation thread constants:
+#define DEFAULT_SIM_HZ 60.0 //the default number of simulation ticks per second
+#define DEFAULT_DISPLAY_HZ 60.0 //the default number of frames rendered per second
+#define DEFAULT_MAX_SUBSTEPS 8 //the default maximum number of ticks simulated for a single frame
+#define FAST_FORWARD_RENDER_INTERVAL 10 //only every this many frames are rendered while fast forwarding
+#define COMMAND_QUEUE_SIZE 1024 //the maximum number of input commands waiting to be applied
+#define DEFAULT_WORLD_PATH "world.esim" //the default file worlds are saved to and loaded from
+#define DEFAULT_RECORDING_PATH "recording.esrc" //the default file input recordings are written to
+
+enum class CommandType //represents all of the commands the input thread can send to the simulation thread
+{
+	addParticles,
+	saveWorld,
+	loadWorld,
+	toggleRecording,
+	rewind
+};
+
+struct SimSettings //controls how the simulation thread runs
+{
+	double simHz; //simulation ticks per second
+	double displayHz; //frames published per second; ticks are run in batches of about simHz / displayHz per frame
+	int maxSubsteps; //the most ticks run for a single frame, any further backlog is dropped so a slow tick can't snowball
+	SpinPolicy spinPolicy; //how frame pacing waits out the last stretch before each frame
+	const char* worldPath; //the file the save and load commands use
+	bool rawSnapshots; //whether the save command writes raw snapshots, which are much larger but load almost instantly
+	const char* recordingPath; //the file the recording command writes to
+	size_t rewindMemory; //the most bytes of rewind history to keep, 0 to disable rewinding
+	double rewindStep; //the number of simulated seconds the rewind command goes back
+};
+
+struct SimCommand //a single input command, applied by the simulation thread before its next tick
+{
+	CommandType type;
+	ParticleType particleType;
+	int brushSize;
+	int x, y;
+
+	Uint64 id; //used to track the command until its result is visible, 0 if untracked
+	std::chrono::steady_clock::time_point inputTime; //when the input that produced the command was sampled
+};
+
+//---------------------------------------------------------------//
+
+SimSettings default_sim_settings(); //returns the default simulation settings
+bool start_sim_thread(const SimSettings& settings); //publishes the first frame and starts running the simulation on its own thread; returns true on success, false on failure
+void stop_sim_thread(); //stops the simulation thread and waits for it to finish, closing any recording in progress
+
+bool push_command(const SimCommand& command); //queues a command for the simulation thread; returns false if the queue is full
+const FrameSnapshot& get_latest_frame(); //returns the most recently completed frame; only call from the render thread
+
+void set_fast_forward(bool enabled); //enables or disables fast forward mode, which runs the simulation as fast as possible instead of at a fixed tick rate
+bool get_fast_forward(); //returns true if fast forward mode is enabled, false otherwise
+double get_ticks_per_second(); //returns the number of ticks simulated over the last second
\ No newline at end of file
@@ -1,14 +1,43 @@
 #include "simulation.h"
 #include "particles.h"
+#include "elements.h"
+#include "reactions.h"
+#include "sim_thread.h"
+#include "latency.h"
+#include "snapshot.h"
+#include "frame_stream.h"
+#include "frame_stats.h"
+#include "bits.h"
+#include "margolus.h"
 #include "SDL_image.h"
 #include <iostream>
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <vector>
 #include <time.h>
 
+static_assert(WIDTH % 64 == 0 && HEIGHT % 64 == 0, "the occupancy bitplanes need rows and columns made of whole 64 bit words");
+
 //global vars:
 static Particle* grid; //the entire grid of simulated particles
+static SnapshotMapping gridMapping; //the raw snapshot the grid is mapped from, if any
+static bool dir; //for alternating iteration direction
+static bool trackChanges; //whether or not writes to the grid are being tracked
+static std::vector<Uint8> changedMarks; //whether or not each cell is already in changedCells
+static std::vector<int> changedCells; //the index of every cell written since the changes were last taken
+static Uint32 populations[MAX_PARTICLE_TYPES]; //the number of particles of every type in the grid
+static Uint32 chunkPopulations[CHUNKS_X * CHUNKS_Y][MAX_PARTICLE_TYPES]; //the number of particles of every type in every chunk
+static Uint64 rowOccupancy[4][HEIGHT][OCCUPANCY_ROW_WORDS]; //a bit for every cell with each flag, row by row
+static Uint64 columnOccupancy[4][WIDTH][OCCUPANCY_COLUMN_WORDS]; //the same bits, column by column
+static Uint64 granularColumns[WIDTH][OCCUPANCY_COLUMN_WORDS]; //a bit for every sand and gunpowder cell, column by column
+static Uint64 dynamicColumns[WIDTH][OCCUPANCY_COLUMN_WORDS]; //a bit for every cell the sweep updates, anything but empty, wood and stone, column by column
+static Uint64 gridWrites; //the number of writes to the grid so far, for telling when bitboards taken from it are out of date
+static bool granularBitboards; //whether or not settled sand and gunpowder are found with bitboards and left at rest instead of updated
+static SimEngine simEngine; //the way ticks are simulated
 SDL_Window* window; //the SDL window
 bool running;
+static unsigned int palette[MAX_PARTICLE_TYPES]; //the properly formatted color of every particle type, indexed by type
 
 //ui surfaces:
 SDL_Surface* particleNames;
@@ -21,55 +50,105 @@ bool displayInstructions;
 //---------------------------------------------------------------//
 
 void inner_sim_loop(int x); //used to allow for alternating iteration direction
-
-bool init_simulation(SDL_Window* newWindow)
+void mark_index(int idx); //adds a cell to the changed list if changes are being tracked
+void submit_command(const SimCommand& command); //sends a command to the stream server if connected to one, otherwise to the local simulation thread
+void change_population(int idx, ParticleType from, ParticleType to); //moves a cell's count from one type to another
+void change_occupancy(int x, int y, ParticleFlag from, ParticleFlag to); //moves a cell's bits from one flag's bitplanes to another's
+void change_columns(int x, int y, ParticleType from, ParticleType to); //sets or clears a cell's granular and dynamic bits if its type changes between having them and not
+int next_dynamic(int x, int y); //returns the bottommost row at or above y where the column has a particle the sweep updates, or -1 if there are none
+void find_settled_granular(int x, Uint64* settled); //sets the bits of the column's sand and gunpowder that can't move this tick: held up below, to both sides and diagonally by solids or the edge of the grid
+void rest_granular(int idx); //applies what an update would to a settled granular particle, without drawing on the rng
+
+bool init_simulation(SDL_Window* newWindow, const char* loadPath)
 {
 	//set window:
 	window = newWindow;
 
-	//generate surfaces:
-	particleNames = IMG_Load("assets/elementNames.png");
-	brushSizes = IMG_Load("assets/brushSizes.png");
-	instructions = IMG_Load("assets/instructions.png");
-	namesSrcRect.x = 0;
-	namesSrcRect.y = 28;
-	namesSrcRect.w = 63;
-	namesSrcRect.h = 7;
-	brushSizeSrcRect.x = 0;
-	brushSizeSrcRect.y = 7;
-	brushSizeSrcRect.w = 89;
-	brushSizeSrcRect.h = 7;
+	//fill the element table with just the built-in elements, unless a config file was loaded:
+	if (elements.count == 0)
+		init_elements(NULL);
+
+	//generate surfaces, unless running headless:
+	if (window)
+	{
+		particleNames = IMG_Load("assets/elementNames.png");
+		brushSizes = IMG_Load("assets/brushSizes.png");
+		instructions = IMG_Load("assets/instructions.png");
+		namesSrcRect.x = 0;
+		namesSrcRect.y = 28;
+		namesSrcRect.w = 63;
+		namesSrcRect.h = 7;
+		brushSizeSrcRect.x = 0;
+		brushSizeSrcRect.y = 7;
+		brushSizeSrcRect.w = 89;
+		brushSizeSrcRect.h = 7;
+
+		//map the particle colors to the window's pixel format:
+		for (int i = 0; i < elements.count; i++)
+			palette[i] = get_color(elements.color[i]);
+	}
 
 	//seed rng:
-	srand((unsigned int)time(NULL));
+	seed_simulation((unsigned int)time(NULL));
 
 	//initialize map:
 	displayInstructions = true;
-	grid = new Particle[WIDTH * HEIGHT];
-	if (!grid)
-		return false;
+	gridMapping.base = NULL;
 
-	//default everything to empty:
-	for (int x = 0; x < WIDTH; x++)
-		for (int y = 0; y < HEIGHT; y++)
-			set_empty(x, y);
+	if (loadPath)
+	{
+		//map raw snapshots straight in, saving a copy of the cells; checking and indexing them still reads every page before the first tick:
+		grid = map_raw_snapshot(loadPath, WIDTH, HEIGHT, &gridMapping);
+		if (!grid)
+		{
+			//otherwise load into a fresh grid, which the snapshot fills completely:
+			grid = new Particle[WIDTH * HEIGHT];
+			if (!grid || !load_snapshot(loadPath, grid, WIDTH, HEIGHT))
+				return false;
+		}
+	}
+	else
+	{
+		grid = new Particle[WIDTH * HEIGHT];
+		if (!grid)
+			return false;
+
+		//default everything to empty:
+		std::fill(grid, grid + WIDTH * HEIGHT, new_particle(ParticleType::empty));
+	}
 
+	reindex_grid();
 	return true;
 }
 
 void close_simulation()
 {
-	delete[] grid;
+	if (gridMapping.base)
+		unmap_raw_snapshot(&gridMapping);
+	else
+		delete[] grid;
 	SDL_FreeSurface(particleNames);
 	SDL_FreeSurface(brushSizes);
 	SDL_FreeSurface(instructions);
 }
 
+void seed_simulation(unsigned int seed)
+{
+	srand(seed);
+	dir = true;
+}
+
 void run_simulation()
 {
-	static bool dir = true; //for alternating iteration direction
 	dir = !dir;
 
+	//the block engine alternates its offset the way the sweep alternates direction:
+	if (simEngine == SimEngine::margolus)
+	{
+		run_margolus(dir);
+		return;
+	}
+
 	//iterate either left->right or right->left to ensure sand/water spreads evenly:
 	if(dir)
 	{
@@ -90,59 +169,76 @@ void run_simulation()
 
 void inner_sim_loop(int x)
 {
-	//iterate over each cell and switch over its type:
-	for (int y = HEIGHT - 1; y >= 0; y--)
+	Uint64 settled[OCCUPANCY_COLUMN_WORDS]; //the column's settled sand and gunpowder, when using granular bitboards
+	Uint64 settledWrites = gridWrites - 1; //the grid writes settled was found after
+
+	//visit the cells the sweep updates from the bottom up, skipping past empty, wood and stone with the column's mask:
+	for (int y = next_dynamic(x, HEIGHT - 1); y >= 0; y = next_dynamic(x, y))
 	{
-		switch (grid[x + y * WIDTH].type)
+		//leave settled sand and gunpowder at rest, finding it again whenever an update below might have knocked some loose;
+		//only granular cells can be settled, so the liquids, gases and fire in a column never pay for finding it:
+		if (granularBitboards && ((granularColumns[x][y / 64] >> (y % 64)) & 1))
 		{
-		case ParticleType::oil:
-			update_oil(x, y);
-			break;
-		case ParticleType::water:
-			update_water(x, y);
-			break;
-		case ParticleType::acid:
-			update_acid(x, y);
-			break;
-		case ParticleType::lava:
-			update_lava(x, y);
-			break;
-		case ParticleType::sand:
-			update_sand(x, y);
-			break;
-		case ParticleType::gunpowder:
-			update_gunpowder(x, y);
-			break;
-		case ParticleType::toxicGas:
-			update_toxic_gas(x, y);
-			break;
-		case ParticleType::steam:
-			update_steam(x, y);
-			break;
-		case ParticleType::smoke:
-			update_smoke(x, y);
-			break;
-		case ParticleType::fire:
-			update_fire(x, y);
-			break;
-		default:
-			break;
+			if (settledWrites != gridWrites)
+			{
+				find_settled_granular(x, settled);
+				settledWrites = gridWrites;
+			}
+
+			if ((settled[y / 64] >> (y % 64)) & 1)
+			{
+				//settled particles that react still do, being left at rest only if they didn't change:
+				if (!(elementDescriptors[(int)grid[x + y * WIDTH].type].classes & ELEMENT_REACTIVE) || !react(x, y))
+					rest_granular(x + y * WIDTH);
+				y--;
+				continue;
+			}
 		}
+
+		//batch the particles of the same type above into one dispatch, unless settled ones among them need leaving at rest:
+		ParticleType type = grid[x + y * WIDTH].type;
+		const ElementDescriptor& element = elementDescriptors[(int)type];
+		int length = 1;
+		if (!granularBitboards || !(element.classes & ELEMENT_GRANULAR))
+			while (y - length >= 0 && grid[x + (y - length) * WIDTH].type == type)
+				length++;
+
+		int count = element.update(x, y, length);
+
+		//every updated particle can change in place, even if it doesn't move:
+		for (int i = 0; i < count; i++)
+			mark_index(x + (y - i) * WIDTH);
+		tickCounters.updated += count;
+		y -= count;
 	}
 }
 
-void render()
+void capture_frame(FrameSnapshot* frame)
+{
+	for (int i = 0; i < WIDTH * HEIGHT; i++)
+		frame->types[i] = (Uint8)grid[i].type;
+}
+
+void render(const FrameSnapshot& frame)
 {
 	//grab window stuff:
 	SDL_Surface* windowSurface = SDL_GetWindowSurface(window);
-	SDL_PixelFormat* format = windowSurface->format;
 	unsigned int* texture = (unsigned int*)windowSurface->pixels;
 
+	//in low latency mode, draw brush inputs the simulation hasn't applied yet on top of the frame:
+	static FrameSnapshot preview;
+	const FrameSnapshot* shown = &frame;
+	if (get_low_latency())
+	{
+		preview_inputs(frame, &preview);
+		shown = &preview;
+	}
+
 	//iterate over every cell, grab its color and render the rectangle:
-	for (int x = 0; x < WIDTH; x++)
-		for (int y = 0; y < HEIGHT; y++)
+	for (int y = 0; y < HEIGHT; y++)
+		for (int x = 0; x < WIDTH; x++)
 		{
-			unsigned int pixel = get_color(grid[x + y * WIDTH].color);
+			unsigned int pixel = palette[shown->types[x + y * WIDTH]];
 
 			for (int i = 0; i < PARTICLE_SIZE; i++)
 				for (int j = 0; j < PARTICLE_SIZE; j++)
@@ -176,6 +272,7 @@ void render()
 	}
 
 	SDL_UpdateWindowSurface(window);
+	record_present(shown->lastCommand);
 }
 
 void handle_input()
@@ -198,6 +295,25 @@ void handle_input()
 			case SDLK_RETURN:
 				displayInstructions = false;
 				break;
+			case SDLK_f:
+				set_fast_forward(!get_fast_forward());
+				break;
+			case SDLK_l:
+				set_low_latency(!get_low_latency());
+				break;
+			case SDLK_F5:
+			case SDLK_F9:
+			case SDLK_r:
+			case SDLK_BACKSPACE:
+			{
+				SDL_Keycode key = event.key.keysym.sym;
+
+				SimCommand command;
+				command.type = key == SDLK_F5 ? CommandType::saveWorld : key == SDLK_F9 ? CommandType::loadWorld : key == SDLK_r ? CommandType::toggleRecording : CommandType::rewind;
+				command.id = 0;
+				submit_command(command);
+				break;
+			}
 			case SDLK_1:
 				particleType = ParticleType::oil;
 				namesSrcRect.y = 0;
@@ -234,6 +350,20 @@ void handle_input()
 				particleType = ParticleType::fire;
 				namesSrcRect.y = 56;
 				break;
+			case SDLK_0:
+			{
+				//cycle through the custom elements, which have no name image:
+				if (elements.count == BUILTIN_ELEMENT_COUNT)
+					break;
+
+				int next = (int)particleType + 1;
+				if (next < BUILTIN_ELEMENT_COUNT || next >= elements.count)
+					next = BUILTIN_ELEMENT_COUNT;
+
+				particleType = (ParticleType)next;
+				std::cout << "selected " << elements.name[next] << std::endl;
+				break;
+			}
 			}
 			break;
 		}
@@ -264,110 +394,59 @@ void handle_input()
 	{
 		int mouseX;
 		int mouseY;
-		if (SDL_GetMouseState(&mouseX, &mouseY) & SDL_BUTTON(SDL_BUTTON_LEFT))
-			add_particles(particleType, brushSize, mouseX / PARTICLE_SIZE, mouseY / PARTICLE_SIZE);
-		else if (SDL_GetMouseState(&mouseX, &mouseY) & SDL_BUTTON(SDL_BUTTON_RIGHT))
-			add_particles(ParticleType::empty, brushSize, mouseX / PARTICLE_SIZE, mouseY / PARTICLE_SIZE);
+		Uint32 buttons = SDL_GetMouseState(&mouseX, &mouseY);
+
+		SimCommand command;
+		command.type = CommandType::addParticles;
+		command.brushSize = brushSize;
+		command.x = mouseX / PARTICLE_SIZE;
+		command.y = mouseY / PARTICLE_SIZE;
+
+		if (buttons & SDL_BUTTON(SDL_BUTTON_LEFT))
+		{
+			command.particleType = particleType;
+			track_input(&command);
+			submit_command(command);
+		}
+		else if (buttons & SDL_BUTTON(SDL_BUTTON_RIGHT))
+		{
+			command.particleType = ParticleType::empty;
+			track_input(&command);
+			submit_command(command);
+		}
 	}
 }
 
 void add_particles(ParticleType type, int brushSize, int x, int y)
 {
-	//set universally default values:
-	Particle pToAdd;
-	pToAdd.type = type;
-	pToAdd.xVel = 0.0f;
-	pToAdd.yVel = 0.0f;
-	pToAdd.updated = false;
-
-	//switch over the type and set type-sepcific default values:
-	switch (type)
+	Particle pToAdd = new_particle(type);
+	if (elements.kernel[(int)type] == Kernel::moveableSolid) //lastX and lastY share memory with fire's health and old type
 	{
-	case ParticleType::oil:
-	{
-		pToAdd.flag = ParticleFlag::liquid;
-		pToAdd.color = OIL_COLOR;
-		break;
-	}
-	case ParticleType::water:
-	{
-		pToAdd.flag = ParticleFlag::liquid;
-		pToAdd.color = WATER_COLOR;
-		break;
-	}
-	case ParticleType::acid:
-	{
-		pToAdd.flag = ParticleFlag::liquid;
-		pToAdd.color = ACID_COLOR;
-		break;
-	}
-	case ParticleType::lava:
-	{
-		pToAdd.flag = ParticleFlag::liquid;
-		pToAdd.color = LAVA_COLOR;
-		break;
-	}
-	case ParticleType::sand:
-	{
-		pToAdd.flag = ParticleFlag::solid;
-		pToAdd.color = SAND_COLOR;
-		pToAdd.freeFall = false;
-		break;
-	}
-	case ParticleType::gunpowder:
-	{
-		pToAdd.flag = ParticleFlag::solid;
-		pToAdd.color = GUNPOWDER_COLOR;
-		pToAdd.freeFall = false;
-		break;
-	}
-	case ParticleType::wood:
-	{
-		pToAdd.flag = ParticleFlag::solid;
-		pToAdd.color = WOOD_COLOR;
-		break;
-	}
-	case ParticleType::stone:
-	{
-		pToAdd.flag = ParticleFlag::solid;
-		pToAdd.color = STONE_COLOR;
-		break;
-	}
-	case ParticleType::fire:
-	{
-		pToAdd.flag = ParticleFlag::solid;
-		pToAdd.color = FIRE_COLOR;
-		pToAdd.health = 5;
-		pToAdd.oldType = ParticleType::empty;
-		pToAdd.oldFlag = ParticleFlag::empty;
-		pToAdd.oldColor = EMPTY_COLOR;
-		break;
-	}
-	case ParticleType::empty:
-	{
-		pToAdd.flag = ParticleFlag::empty;
-		pToAdd.color = EMPTY_COLOR;
-		break;
-	}
+		pToAdd.lastX = x;
+		pToAdd.lastY = y;
 	}
 
 	//add the particles to the grid:
 	if (brushSize == 0)
-		grid[x + y * WIDTH] = pToAdd;
+	{
+		if (in_bounds(x, y))
+			set_p(x, y, pToAdd);
+	}
 	else
 	{
 		//iterate over a square in the grid and add the particles if they are in bounds:
 		for (int i = x - brushSize; i <= x + brushSize; i++)
 			for (int j = y - brushSize; j <= y + brushSize; j++)
 				if (in_bounds(i, j) && (type == ParticleType::empty || grid[i + j * WIDTH].type == ParticleType::empty)) //don't add if they are the same type, avoids the particles getting stuck in the air due to the velocity resetting
-				{
-					pToAdd.lastX = x;
-					pToAdd.lastY = y;
-					grid[i + j * WIDTH] = pToAdd;
-				}
+					set_p(i, j, pToAdd);
 	}
 }
 
+Particle* get_grid()
+{
+	return grid;
+}
+
 Particle* get_p(int x, int y)
 {
 	return &grid[x + y * WIDTH];
@@ -386,18 +465,303 @@ void swap(int x1, int y1, int x2, int y2)
 	Particle temp = grid[x1 + y1 * WIDTH];
 	grid[x1 + y1 * WIDTH] = grid[x2 + y2 * WIDTH];
 	grid[x2 + y2 * WIDTH] = temp;
+	tickCounters.swaps++;
+
+	//the totals don't change, but the counts move if the particles crossed into another chunk:
+	if (x1 / CHUNK_SIZE != x2 / CHUNK_SIZE || y1 / CHUNK_SIZE != y2 / CHUNK_SIZE)
+	{
+		int chunk1 = x1 / CHUNK_SIZE + y1 / CHUNK_SIZE * CHUNKS_X;
+		int chunk2 = x2 / CHUNK_SIZE + y2 / CHUNK_SIZE * CHUNKS_X;
+		chunkPopulations[chunk1][(int)temp.type]--;
+		chunkPopulations[chunk1][(int)grid[x1 + y1 * WIDTH].type]++;
+		chunkPopulations[chunk2][(int)grid[x1 + y1 * WIDTH].type]--;
+		chunkPopulations[chunk2][(int)temp.type]++;
+	}
+
+	change_occupancy(x1, y1, temp.flag, grid[x1 + y1 * WIDTH].flag);
+	change_occupancy(x2, y2, grid[x1 + y1 * WIDTH].flag, temp.flag);
+	change_columns(x1, y1, temp.type, grid[x1 + y1 * WIDTH].type);
+	change_columns(x2, y2, grid[x1 + y1 * WIDTH].type, temp.type);
+	gridWrites++;
+
+	mark_index(x1 + y1 * WIDTH);
+	mark_index(x2 + y2 * WIDTH);
 }
 
 void set_empty(int x, int y)
 {
 	int idx = x + y * WIDTH;
+	change_population(idx, grid[idx].type, ParticleType::empty);
+	change_occupancy(x, y, grid[idx].flag, ParticleFlag::empty);
+	change_columns(x, y, grid[idx].type, ParticleType::empty);
+	gridWrites++;
 	grid[idx].type = ParticleType::empty;
 	grid[idx].flag = ParticleFlag::empty;
 	grid[idx].color = EMPTY_COLOR;
+
+	mark_index(idx);
+}
+
+void set_p(int x, int y, const Particle& p)
+{
+	change_population(x + y * WIDTH, grid[x + y * WIDTH].type, p.type);
+	change_occupancy(x, y, grid[x + y * WIDTH].flag, p.flag);
+	change_columns(x, y, grid[x + y * WIDTH].type, p.type);
+	gridWrites++;
+	grid[x + y * WIDTH] = p;
+	mark_index(x + y * WIDTH);
+}
+
+void mark_changed(int x, int y)
+{
+	mark_index(x + y * WIDTH);
+}
+
+void track_changes(bool enabled)
+{
+	trackChanges = enabled;
+	changedMarks.assign(enabled ? WIDTH * HEIGHT : 0, 0);
+	changedCells.clear();
+}
+
+void take_changes(std::vector<int>* cells)
+{
+	cells->swap(changedCells);
+	changedCells.clear();
+
+	for (int idx : *cells)
+		changedMarks[idx] = 0;
+}
+
+const Uint32* get_populations()
+{
+	return populations;
+}
+
+const Uint32* get_chunk_populations(int chunkX, int chunkY)
+{
+	return chunkPopulations[chunkX + chunkY * CHUNKS_X];
+}
+
+const Uint64* get_row_occupancy(ParticleFlag flag, int y)
+{
+	return rowOccupancy[(int)flag][y];
+}
+
+const Uint64* get_column_occupancy(ParticleFlag flag, int x)
+{
+	return columnOccupancy[(int)flag][x];
+}
+
+void set_granular_bitboards(bool enabled)
+{
+	granularBitboards = enabled;
+}
+
+bool get_granular_bitboards()
+{
+	return granularBitboards;
+}
+
+void set_sim_engine(SimEngine engine)
+{
+	if (engine == SimEngine::margolus)
+		init_margolus();
+
+	simEngine = engine;
+}
+
+SimEngine get_sim_engine()
+{
+	return simEngine;
+}
+
+bool parse_sim_engine(const char* name, SimEngine* engine)
+{
+	if (strcmp(name, "sweep") == 0)
+		*engine = SimEngine::sweep;
+	else if (strcmp(name, "margolus") == 0)
+		*engine = SimEngine::margolus;
+	else
+		return false;
+
+	return true;
+}
+
+int count_empty_run(int x, int y, int dx, int dy, int limit)
+{
+	//walk along the row or column's empty bitplane a word at a time:
+	const Uint64* words = dx != 0 ? rowOccupancy[(int)ParticleFlag::empty][y] : columnOccupancy[(int)ParticleFlag::empty][x];
+	int step = dx != 0 ? dx : dy;
+	int pos = dx != 0 ? x + dx : y + dy;
+	int size = dx != 0 ? WIDTH : HEIGHT;
+
+	int run = 0;
+	while (run < limit && pos >= 0 && pos < size)
+	{
+		//count the set bits from pos towards the end of its word in the direction of travel:
+		Uint64 word = words[pos / 64];
+		int bit = pos % 64;
+		int available, free;
+		if (step > 0)
+		{
+			Uint64 blocked = ~(word >> bit);
+			available = 64 - bit;
+			free = blocked ? lowest_bit(blocked) : 64;
+		}
+		else
+		{
+			Uint64 blocked = ~(word << (63 - bit));
+			available = bit + 1;
+			free = blocked ? 63 - highest_bit(blocked) : 64;
+		}
+
+		free = std::min(free, available);
+		run += free;
+		pos += step * free;
+		if (free < available)
+			break;
+	}
+
+	return std::min(run, limit);
+}
+
+void reindex_grid()
+{
+	memset(populations, 0, sizeof(populations));
+	memset(chunkPopulations, 0, sizeof(chunkPopulations));
+	memset(rowOccupancy, 0, sizeof(rowOccupancy));
+	memset(columnOccupancy, 0, sizeof(columnOccupancy));
+	memset(granularColumns, 0, sizeof(granularColumns));
+	memset(dynamicColumns, 0, sizeof(dynamicColumns));
+	gridWrites++;
+
+	for (int y = 0; y < HEIGHT; y++)
+		for (int x = 0; x < WIDTH; x++)
+		{
+			const Particle& p = grid[x + y * WIDTH];
+			populations[(int)p.type]++;
+			chunkPopulations[x / CHUNK_SIZE + y / CHUNK_SIZE * CHUNKS_X][(int)p.type]++;
+			rowOccupancy[(int)p.flag][y][x / 64] |= (Uint64)1 << (x % 64);
+			columnOccupancy[(int)p.flag][x][y / 64] |= (Uint64)1 << (y % 64);
+			if (elementDescriptors[(int)p.type].classes & ELEMENT_GRANULAR)
+				granularColumns[x][y / 64] |= (Uint64)1 << (y % 64);
+			if (!elementDescriptors[(int)p.type].isStatic)
+				dynamicColumns[x][y / 64] |= (Uint64)1 << (y % 64);
+		}
 }
 
 unsigned int get_color(SDL_Color color)
 {
 	static SDL_PixelFormat* format = SDL_GetWindowSurface(window)->format;
 	return SDL_MapRGB(format, color.r, color.g, color.b);
+}
+
+void mark_index(int idx)
+{
+	if (trackChanges && !changedMarks[idx])
+	{
+		changedMarks[idx] = 1;
+		changedCells.push_back(idx);
+	}
+}
+
+void submit_command(const SimCommand& command)
+{
+	if (stream_connected())
+		send_stream_command(command);
+	else
+		push_command(command);
+}
+
+void change_population(int idx, ParticleType from, ParticleType to)
+{
+	if (from == to)
+		return;
+
+	int chunk = idx % WIDTH / CHUNK_SIZE + idx / WIDTH / CHUNK_SIZE * CHUNKS_X;
+	populations[(int)from]--;
+	populations[(int)to]++;
+	chunkPopulations[chunk][(int)from]--;
+	chunkPopulations[chunk][(int)to]++;
+}
+
+void change_occupancy(int x, int y, ParticleFlag from, ParticleFlag to)
+{
+	if (from == to)
+		return;
+
+	Uint64 rowBit = (Uint64)1 << (x % 64);
+	Uint64 columnBit = (Uint64)1 << (y % 64);
+	rowOccupancy[(int)from][y][x / 64] &= ~rowBit;
+	rowOccupancy[(int)to][y][x / 64] |= rowBit;
+	columnOccupancy[(int)from][x][y / 64] &= ~columnBit;
+	columnOccupancy[(int)to][x][y / 64] |= columnBit;
+}
+
+void change_columns(int x, int y, ParticleType from, ParticleType to)
+{
+	const ElementDescriptor& fromElement = elementDescriptors[(int)from];
+	const ElementDescriptor& toElement = elementDescriptors[(int)to];
+	Uint64 bit = (Uint64)1 << (y % 64);
+
+	if ((fromElement.classes ^ toElement.classes) & ELEMENT_GRANULAR)
+		granularColumns[x][y / 64] ^= bit;
+	if (fromElement.isStatic != toElement.isStatic)
+		dynamicColumns[x][y / 64] ^= bit;
+}
+
+int next_dynamic(int x, int y)
+{
+	if (y < 0)
+		return -1;
+
+	//mask off everything below y in its word, then look through the words above it:
+	for (int i = y / 64; i >= 0; i--)
+	{
+		Uint64 word = dynamicColumns[x][i];
+		if (i == y / 64 && y % 64 != 63)
+			word &= ((Uint64)1 << (y % 64 + 1)) - 1;
+
+		if (word)
+			return i * 64 + highest_bit(word);
+	}
+
+	return -1;
+}
+
+void find_settled_granular(int x, Uint64* settled)
+{
+	//the solid bits of this column and its neighbors, with the edges of the grid counting as solid:
+	const Uint64 edge[OCCUPANCY_COLUMN_WORDS] = {};
+	const Uint64* center = columnOccupancy[(int)ParticleFlag::solid][x];
+	const Uint64* left = x > 0 ? columnOccupancy[(int)ParticleFlag::solid][x - 1] : edge;
+	const Uint64* right = x < WIDTH - 1 ? columnOccupancy[(int)ParticleFlag::solid][x + 1] : edge;
+	Uint64 leftEdge = x > 0 ? 0 : ~(Uint64)0;
+	Uint64 rightEdge = x < WIDTH - 1 ? 0 : ~(Uint64)0;
+
+	for (int i = 0; i < OCCUPANCY_COLUMN_WORDS; i++)
+	{
+		//shift each column up a cell so every bit lines up with the cell above it, bringing in the floor past the last word:
+		Uint64 carry = i + 1 < OCCUPANCY_COLUMN_WORDS ? 0 : (Uint64)1 << 63;
+		Uint64 centerBelow = (center[i] >> 1) | (i + 1 < OCCUPANCY_COLUMN_WORDS ? center[i + 1] << 63 : carry);
+		Uint64 leftBelow = (left[i] >> 1) | (i + 1 < OCCUPANCY_COLUMN_WORDS ? left[i + 1] << 63 : carry);
+		Uint64 rightBelow = (right[i] >> 1) | (i + 1 < OCCUPANCY_COLUMN_WORDS ? right[i + 1] << 63 : carry);
+
+		settled[i] = granularColumns[x][i] & centerBelow & (leftBelow | leftEdge) & (rightBelow | rightEdge) &
+			(left[i] | leftEdge) & (right[i] | rightEdge);
+	}
+}
+
+void rest_granular(int idx)
+{
+	//blocked on every side the particle ends up with no velocity and not in free fall, only write it if that's new:
+	Particle& p = grid[idx];
+	if (p.xVel == 0.0f && p.yVel == 0.0f && !p.freeFall)
+		return;
+
+	p.xVel = 0.0f;
+	p.yVel = 0.0f;
+	p.freeFall = false;
+	mark_index(idx);
 }
\ No newline at end of file
@@ -1,13 +1,25 @@
 #pragma once
 #include "particles.h"
 #include "SDL.h"
+#include <vector>
 
 //global constants:
 #define PARTICLE_SIZE 4 //the size in pixels of every particle on the screen
 #define WIDTH 256 //the width of the grid
 #define HEIGHT 128 //the height of the grid
+#define CHUNK_SIZE 32 //the width and height of the chunks particles are counted in
+#define CHUNKS_X (WIDTH / CHUNK_SIZE)
+#define CHUNKS_Y (HEIGHT / CHUNK_SIZE)
+#define OCCUPANCY_ROW_WORDS (WIDTH / 64) //the number of 64 bit words covering a row of an occupancy bitplane
+#define OCCUPANCY_COLUMN_WORDS (HEIGHT / 64) //the number of 64 bit words covering a column of an occupancy bitplane
 extern bool running; //whether or not the simulation is currently running
 
+enum class SimEngine //the ways a tick can be simulated
+{
+	sweep, //updates particles one at a time, sweeping across the grid in alternating directions
+	margolus //rearranges 2x2 blocks with a table lookup, alternating between even and odd block offsets
+};
+
 //color vars:
 const SDL_Color OIL_COLOR = { 162, 109, 63 };
 const SDL_Color WATER_COLOR = { 51, 136, 222 };
@@ -22,19 +34,48 @@ const SDL_Color STEAM_COLOR = { 204, 209, 229 };
 const SDL_Color SMOKE_COLOR = { 17, 14, 12 };
 const SDL_Color FIRE_COLOR = { 233, 133, 55 };
 const SDL_Color EMPTY_COLOR = { 40, 40, 41 };
+const SDL_Color PARTICLE_COLORS[13] = { OIL_COLOR, WATER_COLOR, ACID_COLOR, LAVA_COLOR, SAND_COLOR, GUNPOWDER_COLOR, WOOD_COLOR, STONE_COLOR,
+	TOXIC_GAS_COLOR, STEAM_COLOR, SMOKE_COLOR, FIRE_COLOR, EMPTY_COLOR }; //the default color of every built-in particle type, indexed by type; the element table holds the colors in use
+
+struct FrameSnapshot //an immutable copy of the grid's particle types, used to render a completed frame
+{
+	Uint8 types[WIDTH * HEIGHT];
+	Uint64 tick; //the simulation tick the frame was captured after
+	Uint64 lastCommand; //the id of the newest tracked input command applied before the frame was captured
+};
 
 //---------------------------------------------------------------//
 
-bool init_simulation(SDL_Window* newWindow); //initializes the simulation; returns true on success, false on failure
+bool init_simulation(SDL_Window* newWindow, const char* loadPath); //initializes the simulation, starting from the world saved at loadPath if it isn't NULL; pass a NULL window to run headless; returns true on success, false on failure
 void close_simulation(); //ends the simulation and cleans up memory
 void run_simulation(); //runs one frame of the simulation
+void seed_simulation(unsigned int seed); //reseeds the rng and resets the sweep direction, so runs from the same world and seed play out identically
 
-void render(); //renders one frame of the simulation
-void handle_input(); //grabs and handles the user input
+void capture_frame(FrameSnapshot* frame); //copies the type of every particle in the grid into the frame
+void render(const FrameSnapshot& frame); //renders one frame of the simulation
+void handle_input(); //grabs the user input and sends it to the simulation thread
 void add_particles(ParticleType type, int brushSize, int x, int y); //adds a large amount of particles to the simulation based on the parameters
 
+Particle* get_grid(); //returns the entire grid, WIDTH * HEIGHT particles in row-major order
 Particle* get_p(int x, int y); //returns the particle at the given position; DOES NOT CHECK IF IN BOUNDS
 bool in_bounds(int x, int y); //returns true if the position is in bounds, false otherwise
 void swap(int x1, int y1, int x2, int y2); //swaps the particles at the given positions
 void set_empty(int x, int y); //sets the particle at the given position to an empty one
+void set_p(int x, int y, const Particle& p); //replaces the particle at the given position; DOES NOT CHECK IF IN BOUNDS
+void mark_changed(int x, int y); //marks the particle at the given position as changed, for particles modified in place through get_p()
+
+void track_changes(bool enabled); //starts or stops keeping a list of the cells written by the simulation and brushes
+void take_changes(std::vector<int>* cells); //swaps out the list of cells written since the last call, in no particular order, and starts a new one
+
+const Uint32* get_populations(); //returns the number of particles of every type in the grid, indexed by type; kept up to date as cells change
+const Uint32* get_chunk_populations(int chunkX, int chunkY); //returns the number of particles of every type in the given chunk, indexed by type; DOES NOT CHECK IF IN BOUNDS
+const Uint64* get_row_occupancy(ParticleFlag flag, int y); //returns the OCCUPANCY_ROW_WORDS words of the given row's bitplane for the flag, bit x % 64 of word x / 64 set if that cell has the flag; DOES NOT CHECK IF IN BOUNDS
+const Uint64* get_column_occupancy(ParticleFlag flag, int x); //returns the OCCUPANCY_COLUMN_WORDS words of the given column's bitplane for the flag, bit y % 64 of word y / 64 set if that cell has the flag; DOES NOT CHECK IF IN BOUNDS
+void set_granular_bitboards(bool enabled); //switches between updating every sand and gunpowder particle and leaving the ones bitboards show can't move at rest; falling and slipping grains are updated one at a time either way; the two play out differently from the same seed
+bool get_granular_bitboards(); //returns true if granular bitboards are in use, false otherwise
+void set_sim_engine(SimEngine engine); //switches the way ticks are simulated; the engines play out differently from the same seed
+SimEngine get_sim_engine(); //returns the way ticks are currently simulated
+bool parse_sim_engine(const char* name, SimEngine* engine); //converts "sweep" or "margolus" to an engine; returns true on success, false on failure
+int count_empty_run(int x, int y, int dx, int dy, int limit); //returns the number of consecutive empty cells from the given position's neighbor in the given direction, up to limit; dx and dy are -1, 0 or 1 with exactly one nonzero, and the run stops at the edge of the grid
+void reindex_grid(); //recounts every particle and rebuilds the occupancy bitplanes; call after writing the grid directly, as loading, importing and rewinding do
 unsigned int get_color(SDL_Color color); //returns the properly formatted color for the given SDL_Color
\ No newline at end of file
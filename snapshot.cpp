@@ -0,0 +1,452 @@
+#include "snapshot.h"
+#include "simulation.h"
+#include "elements.h"
+#include "byte_io.h"
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//snapshot layout, all integers little-endian and varints in LEB128:
+//  header: u32 magic, u16 version, u16 reserved, u32 width, u32 height
+//  type plane: runs of (u8 type, varint length) covering every cell in row-major order
+//  side tables, each a varint entry count followed by entries of (varint gap since the previous entry's index, payload):
+//    flags: cells whose flag isn't the default for their type; payload u8 flag
+//    velocities: liquids and moveable solids with a nonzero velocity; payload f32 xVel, f32 yVel
+//    health: fire, steam and smoke; payload zigzag varint health
+//    burning: fire; payload u8 oldType, u8 oldFlag
+//    free fall: moveable solids in free fall; no payload
+//everything else (color, updated, lastX/lastY) is either derived from the type or reset every frame
+//
+//single particles are encoded with the same side tables: u8 type, u8 bitmask of the side tables the particle is in, then each of their payloads in order
+//
+//raw snapshots trade size for load speed, storing the grid exactly as it sits in memory:
+//  header: RawSnapshotHeader, zero padded to RAW_SNAPSHOT_HEADER_SIZE
+//  particles: width * height Particle structs in row-major order
+//they are only portable between builds with the same Particle layout and byte order, which the header records
+
+#define RAW_BYTE_ORDER_MARK 0x01020304
+
+struct RawSnapshotHeader
+{
+	Uint32 magic;
+	Uint16 version;
+	Uint16 particleSize; //sizeof(Particle) in the build that wrote the snapshot
+	Uint32 byteOrder; //RAW_BYTE_ORDER_MARK as written by the build that wrote the snapshot
+	Uint32 width;
+	Uint32 height;
+};
+
+enum class SideTable //represents every side table, in the order they are stored
+{
+	flags,
+	velocities,
+	health,
+	burning,
+	freeFall,
+	count
+};
+
+//---------------------------------------------------------------//
+
+bool raw_header_matches(const RawSnapshotHeader& header, int width, int height); //returns true if a raw snapshot with the given header can be loaded into a grid of the given size by this build
+bool raw_cells_valid(const Particle* cells, size_t count); //returns true if every type and flag in raw cells, including those a fire restores, is one the element table has
+bool in_side_table(SideTable table, const Particle& p, const Particle& defaultP); //returns true if the particle needs an entry in the given side table
+void write_side_entry(SideTable table, const Particle& p, std::vector<Uint8>* data); //writes the particle's payload for the given side table
+void read_side_entry(SideTable table, ByteReader* reader, Particle* p); //reads the particle's payload for the given side table
+
+void encode_snapshot(const Particle* cells, int width, int height, std::vector<Uint8>* data)
+{
+	size_t count = (size_t)width * height;
+
+	//write header:
+	write_u32(SNAPSHOT_MAGIC, data);
+	write_u16(SNAPSHOT_VERSION, data);
+	write_u16(0, data);
+	write_u32(width, data);
+	write_u32(height, data);
+
+	//write the run-length encoded type plane:
+	for (size_t i = 0; i < count;)
+	{
+		ParticleType type = cells[i].type;
+		size_t run = 1;
+		while (i + run < count && cells[i + run].type == type)
+			run++;
+
+		write_u8((Uint8)type, data);
+		write_varint(run, data);
+		i += run;
+	}
+
+	//count the entries in every side table so the counts can lead:
+	Particle defaults[MAX_PARTICLE_TYPES];
+	for (int i = 0; i < elements.count; i++)
+		defaults[i] = new_particle((ParticleType)i);
+
+	size_t entries[(int)SideTable::count] = {};
+	for (size_t i = 0; i < count; i++)
+		for (int table = 0; table < (int)SideTable::count; table++)
+			if (in_side_table((SideTable)table, cells[i], defaults[(int)cells[i].type]))
+				entries[table]++;
+
+	//write the side tables:
+	for (int table = 0; table < (int)SideTable::count; table++)
+	{
+		write_varint(entries[table], data);
+
+		size_t next = 0; //the index the next entry's gap is measured from
+		for (size_t i = 0; i < count; i++)
+			if (in_side_table((SideTable)table, cells[i], defaults[(int)cells[i].type]))
+			{
+				write_varint(i - next, data);
+				write_side_entry((SideTable)table, cells[i], data);
+				next = i + 1;
+			}
+	}
+}
+
+void encode_particle(const Particle& p, std::vector<Uint8>* data)
+{
+	Particle defaultP = new_particle(p.type);
+
+	Uint8 tables = 0;
+	for (int table = 0; table < (int)SideTable::count; table++)
+		if (in_side_table((SideTable)table, p, defaultP))
+			tables |= 1 << table;
+
+	write_u8((Uint8)p.type, data);
+	write_u8(tables, data);
+	for (int table = 0; table < (int)SideTable::count; table++)
+		if (tables & (1 << table))
+			write_side_entry((SideTable)table, p, data);
+}
+
+bool decode_particle(ByteReader* reader, Particle* p)
+{
+	Uint8 type = read_u8(reader);
+	Uint8 tables = read_u8(reader);
+	if (reader->failed || type >= elements.count)
+		return false;
+
+	*p = new_particle((ParticleType)type);
+	for (int table = 0; table < (int)SideTable::count; table++)
+		if (tables & (1 << table))
+			read_side_entry((SideTable)table, reader, p);
+
+	return !reader->failed;
+}
+
+bool decode_snapshot(const Uint8* data, size_t size, Particle* cells, int width, int height)
+{
+	ByteReader reader = make_byte_reader(data, size);
+
+	size_t count = (size_t)width * height;
+
+	//check header:
+	if (read_u32(&reader) != SNAPSHOT_MAGIC || read_u16(&reader) != SNAPSHOT_VERSION)
+		return false;
+
+	read_u16(&reader);
+	if (read_u32(&reader) != (Uint32)width || read_u32(&reader) != (Uint32)height || reader.failed)
+		return false;
+
+	//read the type plane, filling every cell with its type's defaults:
+	Particle defaults[MAX_PARTICLE_TYPES];
+	for (int i = 0; i < elements.count; i++)
+		defaults[i] = new_particle((ParticleType)i);
+
+	for (size_t i = 0; i < count;)
+	{
+		Uint8 type = read_u8(&reader);
+		Uint64 run = read_varint(&reader);
+		if (reader.failed || type >= elements.count || run == 0 || run > count - i)
+			return false;
+
+		for (Uint64 j = 0; j < run; j++)
+			cells[i++] = defaults[type];
+	}
+
+	//read the side tables:
+	for (int table = 0; table < (int)SideTable::count; table++)
+	{
+		Uint64 entries = read_varint(&reader);
+		if (reader.failed || entries > count)
+			return false;
+
+		size_t idx = 0;
+		for (Uint64 i = 0; i < entries; i++)
+		{
+			Uint64 gap = read_varint(&reader);
+			if (reader.failed || gap >= count - idx)
+				return false;
+
+			idx += (size_t)gap;
+			read_side_entry((SideTable)table, &reader, &cells[idx]);
+			idx++;
+		}
+	}
+
+	return !reader.failed;
+}
+
+bool save_snapshot(const char* path, const Particle* cells, int width, int height)
+{
+	std::vector<Uint8> data;
+	encode_snapshot(cells, width, height, &data);
+
+	SDL_RWops* file = SDL_RWFromFile(path, "wb");
+	if (!file)
+		return false;
+
+	bool success = SDL_RWwrite(file, data.data(), 1, data.size()) == data.size();
+	return SDL_RWclose(file) == 0 && success;
+}
+
+bool load_snapshot(const char* path, Particle* cells, int width, int height)
+{
+	SDL_RWops* file = SDL_RWFromFile(path, "rb");
+	if (!file)
+		return false;
+
+	Sint64 size = SDL_RWsize(file);
+	size_t cellBytes = (size_t)width * height * sizeof(Particle);
+
+	//raw snapshots are read with a single sequential read, into a scratch grid so a corrupt file can't leave the cells half loaded:
+	RawSnapshotHeader header;
+	if (SDL_RWread(file, &header, sizeof(header), 1) == 1 && header.magic == RAW_SNAPSHOT_MAGIC)
+	{
+		std::vector<Particle> read;
+		bool success = raw_header_matches(header, width, height) && size == (Sint64)(RAW_SNAPSHOT_HEADER_SIZE + cellBytes) &&
+			SDL_RWseek(file, RAW_SNAPSHOT_HEADER_SIZE, RW_SEEK_SET) == RAW_SNAPSHOT_HEADER_SIZE;
+		if (success)
+		{
+			read.resize((size_t)width * height);
+			success = SDL_RWread(file, read.data(), 1, cellBytes) == cellBytes && raw_cells_valid(read.data(), read.size());
+		}
+
+		SDL_RWclose(file);
+		if (success)
+			memcpy(cells, read.data(), cellBytes);
+		return success;
+	}
+
+	SDL_RWseek(file, 0, RW_SEEK_SET);
+	std::vector<Uint8> data(size > 0 ? (size_t)size : 0);
+	bool success = size > 0 && SDL_RWread(file, data.data(), 1, data.size()) == data.size();
+	SDL_RWclose(file);
+	if (!success)
+		return false;
+
+	//decode into a scratch grid so a corrupt file can't leave the cells half loaded:
+	std::vector<Particle> decoded((size_t)width * height);
+	if (!decode_snapshot(data.data(), data.size(), decoded.data(), width, height))
+		return false;
+
+	memcpy(cells, decoded.data(), decoded.size() * sizeof(Particle));
+	return true;
+}
+
+bool save_raw_snapshot(const char* path, const Particle* cells, int width, int height)
+{
+	Uint8 header[RAW_SNAPSHOT_HEADER_SIZE] = {};
+	RawSnapshotHeader* h = (RawSnapshotHeader*)header;
+	h->magic = RAW_SNAPSHOT_MAGIC;
+	h->version = RAW_SNAPSHOT_VERSION;
+	h->particleSize = sizeof(Particle);
+	h->byteOrder = RAW_BYTE_ORDER_MARK;
+	h->width = width;
+	h->height = height;
+
+	SDL_RWops* file = SDL_RWFromFile(path, "wb");
+	if (!file)
+		return false;
+
+	size_t cellBytes = (size_t)width * height * sizeof(Particle);
+	bool success = SDL_RWwrite(file, header, 1, sizeof(header)) == sizeof(header) && SDL_RWwrite(file, cells, 1, cellBytes) == cellBytes;
+	return SDL_RWclose(file) == 0 && success;
+}
+
+Particle* map_raw_snapshot(const char* path, int width, int height, SnapshotMapping* mapping)
+{
+	size_t size = RAW_SNAPSHOT_HEADER_SIZE + (size_t)width * height * sizeof(Particle);
+	void* base = NULL;
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	LARGE_INTEGER fileSize;
+	if (GetFileSizeEx(file, &fileSize) && (Uint64)fileSize.QuadPart == size)
+	{
+		HANDLE fileMapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+		if (fileMapping)
+		{
+			base = MapViewOfFile(fileMapping, FILE_MAP_COPY, 0, 0, size);
+			CloseHandle(fileMapping);
+		}
+	}
+	CloseHandle(file);
+#else
+	int file = open(path, O_RDONLY);
+	if (file < 0)
+		return NULL;
+
+	struct stat fileStat;
+	if (fstat(file, &fileStat) == 0 && (size_t)fileStat.st_size == size)
+	{
+		base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+		if (base == MAP_FAILED)
+			base = NULL;
+	}
+	close(file);
+#endif
+
+	if (!base)
+		return NULL;
+
+	mapping->base = base;
+	mapping->size = size;
+
+	Particle* cells = (Particle*)((Uint8*)base + RAW_SNAPSHOT_HEADER_SIZE);
+	if (!raw_header_matches(*(RawSnapshotHeader*)base, width, height) || !raw_cells_valid(cells, (size_t)width * height))
+	{
+		unmap_raw_snapshot(mapping);
+		return NULL;
+	}
+
+	return cells;
+}
+
+void unmap_raw_snapshot(SnapshotMapping* mapping)
+{
+	if (!mapping->base)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(mapping->base);
+#else
+	munmap(mapping->base, mapping->size);
+#endif
+
+	mapping->base = NULL;
+	mapping->size = 0;
+}
+
+//---------------------------------------------------------------//
+
+bool raw_header_matches(const RawSnapshotHeader& header, int width, int height)
+{
+	return header.magic == RAW_SNAPSHOT_MAGIC && header.version == RAW_SNAPSHOT_VERSION && header.particleSize == sizeof(Particle) &&
+		header.byteOrder == RAW_BYTE_ORDER_MARK && header.width == (Uint32)width && header.height == (Uint32)height;
+}
+
+bool raw_cells_valid(const Particle* cells, size_t count)
+{
+	//the cells are indexed by type and flag as soon as they're loaded, so check them all in one pass before using any:
+	for (size_t i = 0; i < count; i++)
+	{
+		const Particle& p = cells[i];
+		if ((unsigned int)p.type >= (unsigned int)elements.count || (unsigned int)p.flag > (unsigned int)ParticleFlag::empty)
+			return false;
+		if (elements.kernel[(int)p.type] == Kernel::fire &&
+			((unsigned int)p.oldType >= (unsigned int)elements.count || (unsigned int)p.oldFlag > (unsigned int)ParticleFlag::empty))
+			return false;
+	}
+
+	return true;
+}
+
+bool in_side_table(SideTable table, const Particle& p, const Particle& defaultP)
+{
+	switch (table)
+	{
+	case SideTable::flags:
+		return p.flag != defaultP.flag;
+	case SideTable::velocities:
+		return (elements.kernel[(int)p.type] == Kernel::liquid || elements.kernel[(int)p.type] == Kernel::moveableSolid) &&
+			(p.xVel != 0.0f || p.yVel != 0.0f);
+	case SideTable::health:
+		return (elements.classes[(int)p.type] & ELEMENT_AGING) || elements.kernel[(int)p.type] == Kernel::fire;
+	case SideTable::burning:
+		return elements.kernel[(int)p.type] == Kernel::fire;
+	case SideTable::freeFall:
+		return elements.kernel[(int)p.type] == Kernel::moveableSolid && p.freeFall;
+	default:
+		return false;
+	}
+}
+
+void write_side_entry(SideTable table, const Particle& p, std::vector<Uint8>* data)
+{
+	switch (table)
+	{
+	case SideTable::flags:
+		write_u8((Uint8)p.flag, data);
+		break;
+	case SideTable::velocities:
+		write_f32(p.xVel, data);
+		write_f32(p.yVel, data);
+		break;
+	case SideTable::health:
+		write_zigzag(p.health, data);
+		break;
+	case SideTable::burning:
+		write_u8((Uint8)p.oldType, data);
+		write_u8((Uint8)p.oldFlag, data);
+		break;
+	default:
+		break;
+	}
+}
+
+void read_side_entry(SideTable table, ByteReader* reader, Particle* p)
+{
+	switch (table)
+	{
+	case SideTable::flags:
+	{
+		Uint8 flag = read_u8(reader);
+		if (flag > (Uint8)ParticleFlag::empty)
+			reader->failed = true;
+		else
+			p->flag = (ParticleFlag)flag;
+		break;
+	}
+	case SideTable::velocities:
+		p->xVel = read_f32(reader);
+		p->yVel = read_f32(reader);
+		break;
+	case SideTable::health:
+		p->health = (int)read_zigzag(reader);
+		break;
+	case SideTable::burning:
+	{
+		Uint8 oldType = read_u8(reader);
+		Uint8 oldFlag = read_u8(reader);
+		if (oldType >= elements.count || oldFlag > (Uint8)ParticleFlag::empty)
+			reader->failed = true;
+		else
+		{
+			p->oldType = (ParticleType)oldType;
+			p->oldFlag = (ParticleFlag)oldFlag;
+			p->oldColor = elements.color[oldType];
+		}
+		break;
+	}
+	case SideTable::freeFall:
+		p->freeFall = true;
+		break;
+	default:
+		break;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+#include "particles.h"
+#include "byte_io.h"
+#include <cstddef>
+#include <vector>
+
+//snapshot constants:
+#define SNAPSHOT_MAGIC 0x4D495345 //"ESIM" when written in little-endian byte order
+#define SNAPSHOT_VERSION 1
+#define RAW_SNAPSHOT_MAGIC 0x52495345 //"ESIR" when written in little-endian byte order
+#define RAW_SNAPSHOT_VERSION 1
+#define RAW_SNAPSHOT_HEADER_SIZE 4096 //the particles start on their own page so they can be mapped straight into memory
+
+struct SnapshotMapping //a raw snapshot file mapped into memory
+{
+	void* base;
+	size_t size;
+};
+
+//---------------------------------------------------------------//
+
+void encode_snapshot(const Particle* cells, int width, int height, std::vector<Uint8>* data); //appends the compact encoding of the given row-major cells to data
+bool decode_snapshot(const Uint8* data, size_t size, Particle* cells, int width, int height); //fills the given row-major cells from an encoded snapshot; returns true on success, false if the data is corrupt or the size doesn't match
+void encode_particle(const Particle& p, std::vector<Uint8>* data); //appends the compact encoding of a single particle, keeping the same fields snapshots do
+bool decode_particle(ByteReader* reader, Particle* p); //reads a single encoded particle; returns true on success, false if the data is corrupt
+
+bool save_snapshot(const char* path, const Particle* cells, int width, int height); //encodes the cells and writes them to a file; returns true on success, false on failure
+bool load_snapshot(const char* path, Particle* cells, int width, int height); //reads a compact or raw snapshot file into the cells; raw snapshots are the fast path, a single sequential read checked in one pass instead of decoded; returns true on success, false on failure
+
+bool save_raw_snapshot(const char* path, const Particle* cells, int width, int height); //writes the cells to a file as-is after a page-sized header, for loading with a single read or mapping; returns true on success, false on failure
+Particle* map_raw_snapshot(const char* path, int width, int height, SnapshotMapping* mapping); //maps a raw snapshot file copy-on-write, so the cells can be used in place without copying them; every cell is checked up front, so every page is read before this returns; returns the cells or NULL on failure, including if any cell has a type or flag the element table doesn't
+void unmap_raw_snapshot(SnapshotMapping* mapping); //unmaps a raw snapshot, discarding any changes made to its cells
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "world_query.h"
+#include "bits.h"
+#include "elements.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+//---------------------------------------------------------------//
+
+void count_chunk(int chunkX, int chunkY, const int* starts, const int* ends, Uint32* counts); //adds the particles in the given spans of each of the chunk's rows to counts, skipping the scan when the counters already have the answer
+long long chunk_distance(int chunkX, int chunkY, int x, int y); //returns the squared distance from the position to the closest cell of the chunk
+
+int get_row_views(int x, int y, int w, int h, std::vector<RowView>* views)
+{
+	views->clear();
+
+	int x0 = std::max(x, 0), x1 = std::min(x + w, WIDTH);
+	int y0 = std::max(y, 0), y1 = std::min(y + h, HEIGHT);
+	if (x0 >= x1)
+		return 0;
+
+	for (int j = y0; j < y1; j++)
+	{
+		RowView view;
+		view.cells = get_p(x0, j);
+		view.x = x0;
+		view.y = j;
+		view.length = x1 - x0;
+		views->push_back(view);
+	}
+
+	return (int)views->size();
+}
+
+void count_in_rect(int x, int y, int w, int h, Uint32* counts)
+{
+	memset(counts, 0, sizeof(Uint32) * MAX_PARTICLE_TYPES);
+
+	int x0 = std::max(x, 0), x1 = std::min(x + w, WIDTH);
+	int y0 = std::max(y, 0), y1 = std::min(y + h, HEIGHT);
+	if (x0 >= x1 || y0 >= y1)
+		return;
+
+	//only visit the chunks the rectangle overlaps:
+	int starts[CHUNK_SIZE], ends[CHUNK_SIZE];
+	for (int chunkY = y0 / CHUNK_SIZE; chunkY <= (y1 - 1) / CHUNK_SIZE; chunkY++)
+		for (int chunkX = x0 / CHUNK_SIZE; chunkX <= (x1 - 1) / CHUNK_SIZE; chunkX++)
+		{
+			for (int i = 0; i < CHUNK_SIZE; i++)
+			{
+				int j = chunkY * CHUNK_SIZE + i;
+				bool inside = j >= y0 && j < y1;
+				starts[i] = inside ? std::max(x0, chunkX * CHUNK_SIZE) : 0;
+				ends[i] = inside ? std::min(x1, (chunkX + 1) * CHUNK_SIZE) : 0;
+			}
+
+			count_chunk(chunkX, chunkY, starts, ends, counts);
+		}
+}
+
+void count_in_circle(int x, int y, int radius, Uint32* counts)
+{
+	memset(counts, 0, sizeof(Uint32) * MAX_PARTICLE_TYPES);
+	if (radius < 0)
+		return;
+
+	int y0 = std::max(y - radius, 0), y1 = std::min(y + radius + 1, HEIGHT);
+	int x0 = std::max(x - radius, 0), x1 = std::min(x + radius + 1, WIDTH);
+	if (x0 >= x1 || y0 >= y1)
+		return;
+
+	//the circle's span on every row it touches, relative to the grid's rows:
+	static int spanStarts[HEIGHT], spanEnds[HEIGHT];
+	for (int j = y0; j < y1; j++)
+	{
+		int half = (int)sqrt((double)radius * radius - (double)(j - y) * (j - y));
+		spanStarts[j] = std::max(x - half, 0);
+		spanEnds[j] = std::min(x + half + 1, WIDTH);
+	}
+
+	int starts[CHUNK_SIZE], ends[CHUNK_SIZE];
+	for (int chunkY = y0 / CHUNK_SIZE; chunkY <= (y1 - 1) / CHUNK_SIZE; chunkY++)
+		for (int chunkX = x0 / CHUNK_SIZE; chunkX <= (x1 - 1) / CHUNK_SIZE; chunkX++)
+		{
+			if (chunk_distance(chunkX, chunkY, x, y) > (long long)radius * radius)
+				continue;
+
+			for (int i = 0; i < CHUNK_SIZE; i++)
+			{
+				int j = chunkY * CHUNK_SIZE + i;
+				bool inside = j >= y0 && j < y1;
+				starts[i] = inside ? std::max(spanStarts[j], chunkX * CHUNK_SIZE) : 0;
+				ends[i] = inside ? std::min(spanEnds[j], (chunkX + 1) * CHUNK_SIZE) : 0;
+			}
+
+			count_chunk(chunkX, chunkY, starts, ends, counts);
+		}
+}
+
+Uint32 count_flag_in_rect(ParticleFlag flag, int x, int y, int w, int h)
+{
+	int x0 = std::max(x, 0), x1 = std::min(x + w, WIDTH);
+	int y0 = std::max(y, 0), y1 = std::min(y + h, HEIGHT);
+	if (x0 >= x1 || y0 >= y1)
+		return 0;
+
+	//count 64 cells at a time from the occupancy bitplanes, masking off the ends of the span:
+	Uint32 count = 0;
+	for (int j = y0; j < y1; j++)
+	{
+		const Uint64* words = get_row_occupancy(flag, j);
+		for (int word = x0 / 64; word <= (x1 - 1) / 64; word++)
+		{
+			int start = std::max(x0 - word * 64, 0);
+			int end = std::min(x1 - word * 64, 64);
+			count += count_bits(words[word] & bit_range(start, end));
+		}
+	}
+
+	return count;
+}
+
+bool find_nearest(ParticleType type, int x, int y, int* foundX, int* foundY)
+{
+	//order the chunks holding the type by how close they could possibly be:
+	std::pair<long long, int> candidates[CHUNKS_X * CHUNKS_Y]; //(squared distance, chunk)
+	int candidateCount = 0;
+
+	for (int chunkY = 0; chunkY < CHUNKS_Y; chunkY++)
+		for (int chunkX = 0; chunkX < CHUNKS_X; chunkX++)
+			if (get_chunk_populations(chunkX, chunkY)[(int)type] > 0)
+				candidates[candidateCount++] = std::make_pair(chunk_distance(chunkX, chunkY, x, y), chunkX + chunkY * CHUNKS_X);
+
+	std::sort(candidates, candidates + candidateCount);
+
+	//scan them in that order, stopping once no remaining chunk can hold anything closer:
+	long long best = LLONG_MAX;
+	for (int i = 0; i < candidateCount && candidates[i].first < best; i++)
+	{
+		int chunkX = candidates[i].second % CHUNKS_X;
+		int chunkY = candidates[i].second / CHUNKS_X;
+
+		for (int j = chunkY * CHUNK_SIZE; j < (chunkY + 1) * CHUNK_SIZE; j++)
+		{
+			const Particle* row = get_p(0, j);
+			for (int k = chunkX * CHUNK_SIZE; k < (chunkX + 1) * CHUNK_SIZE; k++)
+			{
+				if (row[k].type != type)
+					continue;
+
+				long long distance = (long long)(k - x) * (k - x) + (long long)(j - y) * (j - y);
+				if (distance < best)
+				{
+					best = distance;
+					*foundX = k;
+					*foundY = j;
+				}
+			}
+		}
+	}
+
+	return best != LLONG_MAX;
+}
+
+//---------------------------------------------------------------//
+
+void count_chunk(int chunkX, int chunkY, const int* starts, const int* ends, Uint32* counts)
+{
+	const Uint32* populations = get_chunk_populations(chunkX, chunkY);
+
+	int area = 0;
+	for (int i = 0; i < CHUNK_SIZE; i++)
+		area += std::max(ends[i] - starts[i], 0);
+
+	if (area == 0)
+		return;
+
+	//a whole chunk is already counted:
+	if (area == CHUNK_SIZE * CHUNK_SIZE)
+	{
+		for (int i = 0; i < elements.count; i++)
+			counts[i] += populations[i];
+		return;
+	}
+
+	//so is any part of a chunk holding a single type, like open air or solid stone:
+	int first = (int)get_p(chunkX * CHUNK_SIZE, chunkY * CHUNK_SIZE)->type;
+	if (populations[first] == CHUNK_SIZE * CHUNK_SIZE)
+	{
+		counts[first] += area;
+		return;
+	}
+
+	for (int i = 0; i < CHUNK_SIZE; i++)
+	{
+		const Particle* row = get_p(0, chunkY * CHUNK_SIZE + i);
+		for (int k = starts[i]; k < ends[i]; k++)
+			counts[(int)row[k].type]++;
+	}
+}
+
+long long chunk_distance(int chunkX, int chunkY, int x, int y)
+{
+	int closestX = std::min(std::max(x, chunkX * CHUNK_SIZE), (chunkX + 1) * CHUNK_SIZE - 1);
+	int closestY = std::min(std::max(y, chunkY * CHUNK_SIZE), (chunkY + 1) * CHUNK_SIZE - 1);
+
+	return (long long)(closestX - x) * (closestX - x) + (long long)(closestY - y) * (closestY - y);
+}
\ No newline at end of file
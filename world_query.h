@@ -0,0 +1,21 @@
+#pragma once
+#include "simulation.h"
+#include <vector>
+
+//read-only queries over the grid, answered from the chunk population counters wherever a chunk can be skipped or counted whole;
+//only call from the thread running the simulation, or while it isn't running
+
+struct RowView //a view of consecutive cells in a single row of the grid, pointing straight into it; valid until the grid is next written
+{
+	const Particle* cells;
+	int x, y; //the position of the first cell
+	int length;
+};
+
+//---------------------------------------------------------------//
+
+int get_row_views(int x, int y, int w, int h, std::vector<RowView>* views); //replaces views with one per row of the given rectangle, clipped to the grid; returns the number of rows
+void count_in_rect(int x, int y, int w, int h, Uint32* counts); //fills counts, indexed by type and MAX_PARTICLE_TYPES long, with the number of particles of every type in the given rectangle, clipped to the grid
+void count_in_circle(int x, int y, int radius, Uint32* counts); //fills counts, indexed by type and MAX_PARTICLE_TYPES long, with the number of particles of every type within radius of the given position, clipped to the grid
+Uint32 count_flag_in_rect(ParticleFlag flag, int x, int y, int w, int h); //returns the number of cells with the given flag in the given rectangle, clipped to the grid
+bool find_nearest(ParticleType type, int x, int y, int* foundX, int* foundY); //finds the closest particle of the given type to the given position, which may be out of bounds; returns true if one was found, false if there are none
\ No newline at end of file